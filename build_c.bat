@@ -2,14 +2,14 @@
 REM Build script for C Dijkstra implementation (Windows)
 echo 🔨 Building C Dijkstra program...
 
-cd /d "%~dp0\TamilNadu_Router\pbf-map-router\src\backend"
+cd /d "%~dp0pbf-map-router\src\backend" || exit /b 1
 
 REM Compile C program
-gcc -o dijkstra_c.exe dijkstra_c.c -lm -O3
+gcc -o dijkstra_c.exe dijkstra_c.c csr_graph.c delta_stepping.c edge_weights.c route_metrics.c route_worker.c -lm -O3 -pthread
 
 if %ERRORLEVEL% EQU 0 (
     echo ✅ C program compiled successfully!
-    echo 📍 Executable: src/backend/dijkstra_c.exe
+    echo 📍 Executable: pbf-map-router/src/backend/dijkstra_c.exe
 ) else (
     echo ❌ Compilation failed!
     exit /b 1
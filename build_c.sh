@@ -1,16 +1,15 @@
 #!/bin/bash
+set -e
 
 # Build script for C Dijkstra implementation
 echo "🔨 Building C Dijkstra program..."
 
-cd "$(dirname "$0")/src/backend"
+cd "$(dirname "$0")/pbf-map-router/src/backend"
 
 # Compile C program
-gcc -o dijkstra_c dijkstra_c.c -lm -O3
-
-if [ $? -eq 0 ]; then
+if gcc -o dijkstra_c dijkstra_c.c csr_graph.c delta_stepping.c edge_weights.c route_metrics.c route_worker.c -lm -O3 -pthread; then
     echo "✅ C program compiled successfully!"
-    echo "📍 Executable: src/backend/dijkstra_c"
+    echo "📍 Executable: pbf-map-router/src/backend/dijkstra_c"
 else
     echo "❌ Compilation failed!"
     exit 1
@@ -1,7 +1,14 @@
 const path = require('path');
+const os = require('os');
 
 module.exports = {
   PORT: 3000,
   UPLOAD_DIR: path.join(__dirname, '../../uploads/'),
-  MAX_FILE_SIZE: Infinity
+  MAX_FILE_SIZE: Infinity,
+  // Native route worker processes (built by build_c.sh); 0 routes in JS only.
+  // Workers use Unix domain sockets, so they are off on Windows.
+  ROUTE_WORKERS: process.platform === 'win32' ? 0 : 2,
+  ROUTE_WORKER_BIN: path.join(__dirname, 'dijkstra_c'),
+  // Default delta-stepping threads per one-to-all query
+  ONE_TO_ALL_THREADS: Math.min(os.cpus().length, 8)
 };
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "csr_graph.h"
+
+CsrGraph* create_csr_graph(int node_count, int edge_count) {
+    CsrGraph* graph = (CsrGraph*)malloc(sizeof(CsrGraph));
+    graph->node_count = node_count;
+    graph->edge_count = edge_count;
+    graph->offsets = (int*)calloc(node_count + 1, sizeof(int));
+    graph->targets = (int*)malloc(sizeof(int) * (edge_count > 0 ? edge_count : 1));
+    graph->weights = (double*)malloc(sizeof(double) * (edge_count > 0 ? edge_count : 1));
+    return graph;
+}
+
+void free_csr_graph(CsrGraph* graph) {
+    if (graph) {
+        free(graph->offsets);
+        free(graph->targets);
+        free(graph->weights);
+        free(graph);
+    }
+}
+
+CsrGraph* load_csr_graph(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+
+    char magic[4];
+    int header[3];
+    if (fread(magic, 1, 4, file) != 4 || memcmp(magic, CSR_GRAPH_MAGIC, 4) != 0 ||
+        fread(header, sizeof(int), 3, file) != 3 || header[0] != CSR_GRAPH_VERSION ||
+        header[1] < 0 || header[2] < 0) {
+        fclose(file);
+        return NULL;
+    }
+
+    CsrGraph* graph = create_csr_graph(header[1], header[2]);
+    size_t nodes = (size_t)graph->node_count + 1;
+    size_t edges = (size_t)graph->edge_count;
+    int ok = fread(graph->offsets, sizeof(int), nodes, file) == nodes &&
+             fread(graph->targets, sizeof(int), edges, file) == edges &&
+             fread(graph->weights, sizeof(double), edges, file) == edges;
+    fclose(file);
+
+    // Reject offsets or targets that would index out of range
+    if (ok) ok = graph->offsets[0] == 0 && graph->offsets[graph->node_count] == graph->edge_count;
+    for (int i = 0; ok && i < graph->node_count; i++) {
+        if (graph->offsets[i] > graph->offsets[i + 1]) ok = 0;
+    }
+    for (int e = 0; ok && e < graph->edge_count; e++) {
+        if (graph->targets[e] < 0 || graph->targets[e] >= graph->node_count) ok = 0;
+    }
+
+    if (!ok) {
+        free_csr_graph(graph);
+        return NULL;
+    }
+    return graph;
+}
+
+int save_csr_graph(const CsrGraph* graph, const char* path) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return 0;
+
+    int header[3] = { CSR_GRAPH_VERSION, graph->node_count, graph->edge_count };
+    size_t nodes = (size_t)graph->node_count + 1;
+    size_t edges = (size_t)graph->edge_count;
+    int ok = fwrite(CSR_GRAPH_MAGIC, 1, 4, file) == 4 &&
+             fwrite(header, sizeof(int), 3, file) == 3 &&
+             fwrite(graph->offsets, sizeof(int), nodes, file) == nodes &&
+             fwrite(graph->targets, sizeof(int), edges, file) == edges &&
+             fwrite(graph->weights, sizeof(double), edges, file) == edges;
+    return fclose(file) == 0 && ok;
+}
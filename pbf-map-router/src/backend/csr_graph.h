@@ -0,0 +1,35 @@
+#ifndef CSR_GRAPH_H
+#define CSR_GRAPH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Compressed sparse row graph: edges of node i are
+// targets[offsets[i]] .. targets[offsets[i + 1] - 1]
+typedef struct CsrGraph {
+    int node_count;
+    int edge_count;
+    int* offsets;
+    int* targets;
+    double* weights;
+} CsrGraph;
+
+CsrGraph* create_csr_graph(int node_count, int edge_count);
+void free_csr_graph(CsrGraph* graph);
+
+// Binary graph file, little-endian:
+//   char magic[4] = "CSRG", int32 version, int32 node_count, int32 edge_count,
+//   int32 offsets[node_count + 1], int32 targets[edge_count], float64 weights[edge_count]
+#define CSR_GRAPH_MAGIC "CSRG"
+#define CSR_GRAPH_VERSION 1
+
+// Returns NULL if the file is missing, truncated or not a graph file
+CsrGraph* load_csr_graph(const char* path);
+int save_csr_graph(const CsrGraph* graph, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,376 @@
+#include <stdlib.h>
+#include <float.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "delta_stepping.h"
+#include "route_metrics.h"
+
+// Growable int array (bucket contents, frontiers)
+typedef struct IntVector {
+    int* data;
+    int size;
+    int capacity;
+} IntVector;
+
+// Pending relaxation sent to the thread that owns `target`
+typedef struct RelaxRequest {
+    int target;
+    int pred;
+    double distance;
+} RelaxRequest;
+
+typedef struct RequestVector {
+    RelaxRequest* data;
+    int size;
+    int capacity;
+} RequestVector;
+
+// Every live entry sits within max_weight / delta + 1 buckets of the one
+// being processed, so buckets are a ring indexed by bucket % ring size.
+// delta is floored at max_weight / DELTA_MAX_BUCKET_SPAN to bound the ring.
+#define DELTA_MAX_BUCKET_SPAN 65536
+#define DELTA_NO_BUCKET LLONG_MAX
+
+// Per-thread state. Thread t owns every node v with v % num_threads == t:
+// only t writes distances[v], previous[v] and keeps v in its buckets.
+typedef struct DeltaThread {
+    IntVector* buckets;      // ring of state->bucket_mask + 1 buckets
+    IntVector frontier;
+    IntVector settled;
+    RequestVector* outbox;   // outbox[t] holds requests for thread t
+    long long min_bucket;
+    int has_work;
+    long long relaxations;
+} DeltaThread;
+
+typedef struct DeltaState {
+    const CsrGraph* graph;
+    const WeightSnapshot* overrides;   // NULL: use graph->weights
+    int* light_end;          // edges [offsets[v], light_end[v]) are light
+    int* node_end;           // heavy edges run to node_end[v]; closed ones are dropped
+    int* targets;            // edges reordered light-first per node
+    double* weights;
+    double delta;
+    long long bucket_mask;
+    int num_threads;
+    double* distances;
+    int* previous;
+    double* processed_dist;  // distance at which a node was last expanded
+    long long* settled_bucket;  // last bucket a node was added to `settled` in
+    DeltaThread* threads;
+    pthread_barrier_t barrier;
+    int buckets_processed;
+    int phases;
+} DeltaState;
+
+typedef struct DeltaWorkerArgs {
+    DeltaState* state;
+    int tid;
+} DeltaWorkerArgs;
+
+static void int_vector_push(IntVector* vec, int value) {
+    if (vec->size >= vec->capacity) {
+        vec->capacity = vec->capacity ? vec->capacity * 2 : 16;
+        vec->data = (int*)realloc(vec->data, sizeof(int) * vec->capacity);
+    }
+    vec->data[vec->size++] = value;
+}
+
+static void request_vector_push(RequestVector* vec, int target, int pred, double distance) {
+    if (vec->size >= vec->capacity) {
+        vec->capacity = vec->capacity ? vec->capacity * 2 : 64;
+        vec->data = (RelaxRequest*)realloc(vec->data, sizeof(RelaxRequest) * vec->capacity);
+    }
+    vec->data[vec->size].target = target;
+    vec->data[vec->size].pred = pred;
+    vec->data[vec->size].distance = distance;
+    vec->size++;
+}
+
+static long long bucket_index(double distance, double delta) {
+    double index = distance / delta;
+    return index >= 4e18 ? (long long)4e18 : (long long)index;
+}
+
+static IntVector* bucket_at(DeltaState* state, DeltaThread* thread, long long bucket) {
+    return &thread->buckets[bucket & state->bucket_mask];
+}
+
+// Live entries all lie in [from, from + ring size), so one lap finds the minimum
+static long long find_min_bucket(DeltaState* state, DeltaThread* thread, long long from) {
+    for (long long i = from; i <= from + state->bucket_mask; i++) {
+        if (bucket_at(state, thread, i)->size > 0) return i;
+    }
+    return DELTA_NO_BUCKET;
+}
+
+// Emit relaxation requests for edges [begin, end) of `node` into the
+// thread-local outboxes, grouped by owner of the target.
+static void generate_requests(DeltaState* state, DeltaThread* self, int node, int begin, int end) {
+    double base = state->distances[node];
+    for (int e = begin; e < end; e++) {
+        int to = state->targets[e];
+        request_vector_push(&self->outbox[to % state->num_threads], to, node, base + state->weights[e]);
+    }
+    self->relaxations += end - begin;
+}
+
+// Apply every request addressed to this thread. Improved nodes are
+// (re)inserted into their new bucket; stale copies are skipped on pop.
+static void apply_requests(DeltaState* state, int tid) {
+    DeltaThread* self = &state->threads[tid];
+    for (int s = 0; s < state->num_threads; s++) {
+        RequestVector* inbox = &state->threads[s].outbox[tid];
+        for (int r = 0; r < inbox->size; r++) {
+            RelaxRequest* req = &inbox->data[r];
+            if (req->distance < state->distances[req->target]) {
+                state->distances[req->target] = req->distance;
+                state->previous[req->target] = req->pred;
+                int_vector_push(bucket_at(state, self, bucket_index(req->distance, state->delta)), req->target);
+            }
+        }
+        inbox->size = 0;
+    }
+}
+
+static void* delta_stepping_worker(void* arg) {
+    DeltaWorkerArgs* args = (DeltaWorkerArgs*)arg;
+    DeltaState* state = args->state;
+    int tid = args->tid;
+    DeltaThread* self = &state->threads[tid];
+    const int* offsets = state->graph->offsets;
+    long long current = 0;
+
+    while (1) {
+        // Agree on the lowest non-empty bucket across all threads
+        self->min_bucket = find_min_bucket(state, self, current);
+        pthread_barrier_wait(&state->barrier);
+        long long next = DELTA_NO_BUCKET;
+        for (int t = 0; t < state->num_threads; t++) {
+            if (state->threads[t].min_bucket < next) next = state->threads[t].min_bucket;
+        }
+        if (next == DELTA_NO_BUCKET) break;
+        current = next;
+        self->settled.size = 0;
+        if (tid == 0) state->buckets_processed++;
+
+        // Light phases: repeat until bucket `current` stays empty everywhere
+        while (1) {
+            // Swap bucket `current` into the frontier, recycling the old buffer
+            IntVector* bucket = bucket_at(state, self, current);
+            IntVector taken = *bucket;
+            *bucket = self->frontier;
+            bucket->size = 0;
+            self->frontier = taken;
+
+            for (int i = 0; i < self->frontier.size; i++) {
+                int node = self->frontier.data[i];
+                double dist = state->distances[node];
+                if (bucket_index(dist, state->delta) != current) continue;
+                if (state->processed_dist[node] == dist) continue;
+                state->processed_dist[node] = dist;
+                if (state->settled_bucket[node] != current) {
+                    state->settled_bucket[node] = current;
+                    int_vector_push(&self->settled, node);
+                }
+                generate_requests(state, self, node, offsets[node], state->light_end[node]);
+            }
+
+            pthread_barrier_wait(&state->barrier);
+            apply_requests(state, tid);
+            self->has_work = bucket_at(state, self, current)->size > 0;
+            if (tid == 0) state->phases++;
+            pthread_barrier_wait(&state->barrier);
+
+            int any = 0;
+            for (int t = 0; t < state->num_threads; t++) {
+                if (state->threads[t].has_work) { any = 1; break; }
+            }
+            if (!any) break;
+        }
+
+        // Heavy phase: nodes settled in this bucket relax their heavy edges once
+        for (int i = 0; i < self->settled.size; i++) {
+            int node = self->settled.data[i];
+            generate_requests(state, self, node, state->light_end[node], state->node_end[node]);
+        }
+        pthread_barrier_wait(&state->barrier);
+        apply_requests(state, tid);
+    }
+
+    return NULL;
+}
+
+static double edge_weight(const CsrGraph* graph, const WeightSnapshot* overrides, int edge) {
+    return overrides ? weight_snapshot_get(overrides, edge) : graph->weights[edge];
+}
+
+// Copy edges so each node's light edges (weight <= delta) come first.
+// Closed edges are dropped here so they are never relaxed.
+static void partition_edges(DeltaState* state) {
+    const CsrGraph* graph = state->graph;
+    for (int v = 0; v < graph->node_count; v++) {
+        int write = graph->offsets[v];
+        for (int e = graph->offsets[v]; e < graph->offsets[v + 1]; e++) {
+            double weight = edge_weight(graph, state->overrides, e);
+            if (weight <= state->delta) {
+                state->targets[write] = graph->targets[e];
+                state->weights[write] = weight;
+                write++;
+            }
+        }
+        state->light_end[v] = write;
+        for (int e = graph->offsets[v]; e < graph->offsets[v + 1]; e++) {
+            double weight = edge_weight(graph, state->overrides, e);
+            if (weight > state->delta && weight != EDGE_WEIGHT_CLOSED) {
+                state->targets[write] = graph->targets[e];
+                state->weights[write] = weight;
+                write++;
+            }
+        }
+        state->node_end[v] = write;
+    }
+}
+
+DeltaSteppingResult* delta_stepping_c(const CsrGraph* graph, int start, double delta, int num_threads) {
+    return delta_stepping_weighted_c(graph, NULL, start, delta, num_threads);
+}
+
+DeltaSteppingResult* delta_stepping_weighted_c(const CsrGraph* graph, const WeightSnapshot* weights,
+                                               int start, double delta, int num_threads) {
+    int node_count = graph->node_count;
+    int edge_count = graph->edge_count;
+
+    DeltaSteppingResult* result = (DeltaSteppingResult*)malloc(sizeof(DeltaSteppingResult));
+    result->distances = (double*)malloc(sizeof(double) * (node_count > 0 ? node_count : 1));
+    result->previous = (int*)malloc(sizeof(int) * (node_count > 0 ? node_count : 1));
+    result->node_count = node_count;
+    result->buckets_processed = 0;
+    result->phases = 0;
+    result->relaxations = 0;
+
+    for (int i = 0; i < node_count; i++) {
+        result->distances[i] = DBL_MAX;
+        result->previous[i] = -1;
+    }
+    if (start < 0 || start >= node_count) return result;
+    double search_start = metrics_now();
+
+    if (num_threads < 1) num_threads = 1;
+
+    double total = 0.0;
+    double max_weight = 0.0;
+    int open_edges = 0;
+    for (int e = 0; e < edge_count; e++) {
+        double weight = edge_weight(graph, weights, e);
+        if (weight == EDGE_WEIGHT_CLOSED) continue;
+        total += weight;
+        if (weight > max_weight) max_weight = weight;
+        open_edges++;
+    }
+    // NaN, infinite and non-positive deltas all mean "auto"
+    if (!(delta > 0.0) || isinf(delta)) {
+        delta = open_edges > 0 && total > 0.0 ? total / open_edges : 1.0;
+    }
+    if (delta < max_weight / DELTA_MAX_BUCKET_SPAN) delta = max_weight / DELTA_MAX_BUCKET_SPAN;
+
+    long long ring_size = 64;
+    while (ring_size <= (long long)(max_weight / delta) + 1) ring_size *= 2;
+
+    DeltaState state;
+    state.graph = graph;
+    state.overrides = weights;
+    state.delta = delta;
+    state.bucket_mask = ring_size - 1;
+    state.num_threads = num_threads;
+    state.distances = result->distances;
+    state.previous = result->previous;
+    state.light_end = (int*)malloc(sizeof(int) * node_count);
+    state.node_end = (int*)malloc(sizeof(int) * node_count);
+    state.targets = (int*)malloc(sizeof(int) * (edge_count > 0 ? edge_count : 1));
+    state.weights = (double*)malloc(sizeof(double) * (edge_count > 0 ? edge_count : 1));
+    state.processed_dist = (double*)malloc(sizeof(double) * node_count);
+    state.settled_bucket = (long long*)malloc(sizeof(long long) * node_count);
+    state.buckets_processed = 0;
+    state.phases = 0;
+    for (int i = 0; i < node_count; i++) {
+        state.processed_dist[i] = -1.0;
+        state.settled_bucket[i] = -1;
+    }
+    partition_edges(&state);
+
+    state.threads = (DeltaThread*)calloc(num_threads, sizeof(DeltaThread));
+    for (int t = 0; t < num_threads; t++) {
+        state.threads[t].buckets = (IntVector*)calloc(ring_size, sizeof(IntVector));
+        state.threads[t].outbox = (RequestVector*)calloc(num_threads, sizeof(RequestVector));
+    }
+
+    state.distances[start] = 0.0;
+    int_vector_push(bucket_at(&state, &state.threads[start % num_threads], 0), start);
+
+    pthread_barrier_init(&state.barrier, NULL, num_threads);
+    pthread_t* workers = (pthread_t*)malloc(sizeof(pthread_t) * num_threads);
+    DeltaWorkerArgs* args = (DeltaWorkerArgs*)malloc(sizeof(DeltaWorkerArgs) * num_threads);
+    for (int t = 0; t < num_threads; t++) {
+        args[t].state = &state;
+        args[t].tid = t;
+    }
+    for (int t = 1; t < num_threads; t++) {
+        pthread_create(&workers[t], NULL, delta_stepping_worker, &args[t]);
+    }
+    delta_stepping_worker(&args[0]);
+    for (int t = 1; t < num_threads; t++) {
+        pthread_join(workers[t], NULL);
+    }
+    pthread_barrier_destroy(&state.barrier);
+
+    result->buckets_processed = state.buckets_processed;
+    result->phases = state.phases;
+
+    // Cleanup
+    long long bytes = (long long)node_count * (sizeof(int) * 2 + sizeof(long long) + sizeof(double)) +
+                      (long long)edge_count * (sizeof(int) + sizeof(double));
+    for (int t = 0; t < num_threads; t++) {
+        DeltaThread* thread = &state.threads[t];
+        result->relaxations += thread->relaxations;
+        bytes += ring_size * sizeof(IntVector);
+        for (long long b = 0; b < ring_size; b++) bytes += (long long)thread->buckets[b].capacity * sizeof(int);
+        for (int s = 0; s < num_threads; s++) bytes += (long long)thread->outbox[s].capacity * sizeof(RelaxRequest);
+        for (long long b = 0; b < ring_size; b++) free(thread->buckets[b].data);
+        free(thread->buckets);
+        free(thread->frontier.data);
+        free(thread->settled.data);
+        for (int s = 0; s < num_threads; s++) free(thread->outbox[s].data);
+        free(thread->outbox);
+    }
+    free(state.threads);
+    free(workers);
+    free(args);
+    free(state.light_end);
+    free(state.node_end);
+    free(state.targets);
+    free(state.weights);
+    free(state.processed_dist);
+    free(state.settled_bucket);
+
+    long long settled = 0;
+    for (int i = 0; i < node_count; i++) {
+        if (result->distances[i] != DBL_MAX) settled++;
+    }
+    metrics_add(METRIC_RELAXATIONS, result->relaxations);
+    metrics_add(METRIC_SETTLED_NODES, settled);
+    metrics_add(METRIC_BYTES_ALLOCATED, bytes);
+    metrics_observe(METRIC_PHASE_SEARCH, metrics_now() - search_start);
+
+    return result;
+}
+
+void free_delta_stepping_result(DeltaSteppingResult* result) {
+    if (result) {
+        if (result->distances) free(result->distances);
+        if (result->previous) free(result->previous);
+        free(result);
+    }
+}
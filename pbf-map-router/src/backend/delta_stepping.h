@@ -0,0 +1,37 @@
+#ifndef DELTA_STEPPING_H
+#define DELTA_STEPPING_H
+
+#include "csr_graph.h"
+#include "edge_weights.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One-to-all shortest path result. Unreachable nodes keep
+// distance DBL_MAX and previous -1.
+typedef struct DeltaSteppingResult {
+    double* distances;
+    int* previous;
+    int node_count;
+    int buckets_processed;
+    int phases;
+    long long relaxations;
+} DeltaSteppingResult;
+
+// Parallel delta-stepping SSSP over a CSR graph.
+// A non-positive or non-finite delta picks the average edge weight, and delta
+// is raised to at least max edge weight / 65536; num_threads <= 0 uses one thread.
+DeltaSteppingResult* delta_stepping_c(const CsrGraph* graph, int start, double delta, int num_threads);
+
+// Same, reading edge weights from a pinned override snapshot instead of
+// graph->weights. Closed edges are never relaxed.
+DeltaSteppingResult* delta_stepping_weighted_c(const CsrGraph* graph, const WeightSnapshot* weights,
+                                               int start, double delta, int num_threads);
+void free_delta_stepping_result(DeltaSteppingResult* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
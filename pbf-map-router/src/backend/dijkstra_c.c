@@ -4,18 +4,12 @@
 #include <float.h>
 #include <math.h>
 #include <stdbool.h>
+#include <time.h>
 
-// Graph edge structure
-typedef struct Edge {
-    int to;
-    double dist;
-    struct Edge* next;
-} Edge;
-
-// Graph node structure
-typedef struct Node {
-    Edge* edges;
-} Node;
+#include "dijkstra_c.h"
+#include "delta_stepping.h"
+#include "route_metrics.h"
+#include "route_worker.h"
 
 // Priority queue structure (binary heap)
 typedef struct HeapNode {
@@ -29,16 +23,6 @@ typedef struct PriorityQueue {
     int capacity;
 } PriorityQueue;
 
-// Dijkstra result structure
-typedef struct DijkstraResult {
-    int* path;
-    int path_length;
-    double distance;
-    int* explored;
-    int explored_count;
-    int iterations;
-} DijkstraResult;
-
 // Earth distance calculation
 double calculate_distance(double lat1, double lon1, double lat2, double lon2) {
     const double R = 6371.0; // Earth radius in km
@@ -99,7 +83,11 @@ void heap_sink_down(PriorityQueue* pq, int index) {
 }
 
 void heap_push(PriorityQueue* pq, int node, double distance) {
-    if (pq->size >= pq->capacity) return;
+    if (pq->size >= pq->capacity) {
+        // Lazy deletion can push up to one entry per edge
+        pq->capacity = pq->capacity ? pq->capacity * 2 : 16;
+        pq->heap = (HeapNode*)realloc(pq->heap, sizeof(HeapNode) * pq->capacity);
+    }
     pq->heap[pq->size].node = node;
     pq->heap[pq->size].distance = distance;
     heap_bubble_up(pq, pq->size);
@@ -123,7 +111,10 @@ int heap_is_empty(PriorityQueue* pq) {
 }
 
 // Main Dijkstra algorithm in C
-DijkstraResult* dijkstra_path_c(Node* graph, int node_count, int start, int end, bool with_steps) {
+DijkstraResult* dijkstra_path_c(const CsrGraph* graph, const WeightSnapshot* weights,
+                                int start, int end, bool with_steps) {
+    int node_count = graph->node_count;
+
     // Allocate result structure
     DijkstraResult* result = (DijkstraResult*)malloc(sizeof(DijkstraResult));
     result->path = NULL;
@@ -132,7 +123,12 @@ DijkstraResult* dijkstra_path_c(Node* graph, int node_count, int start, int end,
     result->explored = NULL;
     result->explored_count = 0;
     result->iterations = 0;
+    result->distances = NULL;
+    if (start < 0 || start >= node_count) return result;
     
+    double search_start = metrics_now();
+    long long pops = 0, stale_pops = 0, relaxations = 0, pushes = 1;
+
     // Distance and previous arrays
     double* distances = (double*)malloc(sizeof(double) * node_count);
     int* previous = (int*)malloc(sizeof(int) * node_count);
@@ -166,8 +162,12 @@ DijkstraResult* dijkstra_path_c(Node* graph, int node_count, int start, int end,
         int current;
         double current_dist;
         if (!heap_pop(pq, &current, &current_dist)) break;
+        pops++;
         
-        if (visited[current]) continue;
+        if (visited[current]) {
+            stale_pops++;
+            continue;
+        }
         visited[current] = 1;
         iterations++;
         
@@ -183,19 +183,24 @@ DijkstraResult* dijkstra_path_c(Node* graph, int node_count, int start, int end,
             break;
         }
         
-        // Explore neighbors
-        Edge* edge = graph[current].edges;
-        while (edge) {
-            double alt = current_dist + edge->dist;
-            if (alt < distances[edge->to]) {
-                distances[edge->to] = alt;
-                previous[edge->to] = current;
-                heap_push(pq, edge->to, alt);
+        // Explore neighbors (closed edges weigh HUGE_VAL and never improve)
+        for (int e = graph->offsets[current]; e < graph->offsets[current + 1]; e++) {
+            int to = graph->targets[e];
+            double weight = weights ? weight_snapshot_get(weights, e) : graph->weights[e];
+            double alt = current_dist + weight;
+            relaxations++;
+            if (alt < distances[to]) {
+                distances[to] = alt;
+                previous[to] = current;
+                heap_push(pq, to, alt);
+                pushes++;
             }
-            edge = edge->next;
         }
     }
     
+    double path_start = metrics_now();
+    metrics_observe(METRIC_PHASE_SEARCH, path_start - search_start);
+
     // Build path if found
     if (destination_found && distances[end] != DBL_MAX) {
         result->distance = distances[end];
@@ -220,6 +225,16 @@ DijkstraResult* dijkstra_path_c(Node* graph, int node_count, int start, int end,
     }
     
     result->iterations = iterations;
+    metrics_observe(METRIC_PHASE_PATH, metrics_now() - path_start);
+
+    metrics_add(METRIC_HEAP_PUSHES, pushes);
+    metrics_add(METRIC_HEAP_POPS, pops);
+    metrics_add(METRIC_STALE_POPS, stale_pops);
+    metrics_add(METRIC_RELAXATIONS, relaxations);
+    metrics_add(METRIC_SETTLED_NODES, iterations);
+    metrics_add(METRIC_BYTES_ALLOCATED, (long long)node_count * (sizeof(double) + 2 * sizeof(int)) +
+                (long long)pq->capacity * sizeof(HeapNode) +
+                (long long)explored_capacity * (sizeof(int) + sizeof(double)));
     
     // Copy explored data to result
     if (with_steps && result->explored_count > 0) {
@@ -231,7 +246,11 @@ DijkstraResult* dijkstra_path_c(Node* graph, int node_count, int start, int end,
     
     // Cleanup
     free_priority_queue(pq);
-    free(distances);
+    if (end < 0) {
+        result->distances = distances;
+    } else {
+        free(distances);
+    }
     free(previous);
     free(visited);
     if (explored_nodes) free(explored_nodes);
@@ -244,158 +263,108 @@ void free_dijkstra_result(DijkstraResult* result) {
     if (result) {
         if (result->path) free(result->path);
         if (result->explored) free(result->explored);
+        if (result->distances) free(result->distances);
         free(result);
     }
 }
 
-void free_graph(Node* graph, int node_count) {
-    for (int i = 0; i < node_count; i++) {
-        Edge* edge = graph[i].edges;
-        while (edge) {
-            Edge* next = edge->next;
-            free(edge);
-            edge = next;
-        }
-    }
-    free(graph);
+static double elapsed_ms(struct timespec* from, struct timespec* to) {
+    return (to->tv_sec - from->tv_sec) * 1000.0 + (to->tv_nsec - from->tv_nsec) / 1e6;
 }
 
-// Parse JSON graph from stdin
-Node* parse_graph_from_json(int* node_count) {
-    char buffer[10000000]; // 10MB buffer
-    int pos = 0;
-    
-    // Read entire stdin
-    while (fgets(buffer + pos, sizeof(buffer) - pos, stdin)) {
-        pos += strlen(buffer + pos);
+// Synthetic road-like grid with segment lengths between 10 m and 200 m
+static CsrGraph* build_grid_graph(int side) {
+    int node_count = side * side;
+    double* horizontal = (double*)malloc(sizeof(double) * node_count);  // v -> v + 1
+    double* vertical = (double*)malloc(sizeof(double) * node_count);    // v -> v + side
+    srand(42);
+    for (int v = 0; v < node_count; v++) {
+        horizontal[v] = 0.01 + 0.19 * rand() / RAND_MAX;
+        vertical[v] = 0.01 + 0.19 * rand() / RAND_MAX;
     }
-    buffer[pos] = '\0';
-    
-    // Simple JSON parsing - find node count
-    *node_count = 0;
-    char* ptr = buffer;
-    while (*ptr) {
-        if (*ptr == ':') (*node_count)++;
-        ptr++;
-    }
-    
-    Node* graph = (Node*)calloc(*node_count, sizeof(Node));
-    
-    // Parse edges (simplified - assumes specific JSON format)
-    ptr = buffer;
-    int current_node = 0;
-    
-    while (*ptr) {
-        // Skip to node data
-        while (*ptr && *ptr != '[') ptr++;
-        if (!*ptr) break;
-        ptr++; // skip '['
-        
-        // Parse edges for this node
-        while (*ptr && *ptr != ']') {
-            // Skip to edge object
-            while (*ptr && *ptr != '{') ptr++;
-            if (!*ptr) break;
-            ptr++; // skip '{'
-            
-            // Parse "to" value
-            while (*ptr && strncmp(ptr, "\"to\":", 5) != 0) ptr++;
-            if (!*ptr) break;
-            ptr += 5; // skip "to":
-            
-            int to = 0;
-            while (*ptr && (*ptr < '0' || *ptr > '9')) ptr++;
-            while (*ptr && *ptr >= '0' && *ptr <= '9') {
-                to = to * 10 + (*ptr - '0');
-                ptr++;
-            }
-            
-            // Parse "dist" value
-            while (*ptr && strncmp(ptr, "\"dist\":", 7) != 0) ptr++;
-            if (!*ptr) break;
-            ptr += 7; // skip "dist":
-            
-            double dist = 0.0;
-            while (*ptr && (*ptr < '0' || *ptr > '9') && *ptr != '.') ptr++;
-            bool decimal = false;
-            double divisor = 1.0;
-            while (*ptr && ((*ptr >= '0' && *ptr <= '9') || *ptr == '.')) {
-                if (*ptr == '.') {
-                    decimal = true;
-                } else if (!decimal) {
-                    dist = dist * 10 + (*ptr - '0');
-                } else {
-                    divisor *= 10.0;
-                    dist = dist + (*ptr - '0') / divisor;
-                }
-                ptr++;
-            }
-            
-            // Add edge to graph
-            Edge* edge = (Edge*)malloc(sizeof(Edge));
-            edge->to = to;
-            edge->dist = dist;
-            edge->next = graph[current_node].edges;
-            graph[current_node].edges = edge;
-            
-            // Skip to next edge
-            while (*ptr && *ptr != '}') ptr++;
-            if (*ptr) ptr++; // skip '}'
-            while (*ptr && (*ptr == ',' || *ptr == ' ' || *ptr == '\n')) ptr++;
-        }
-        
-        current_node++;
-        if (current_node >= *node_count) break;
+
+    CsrGraph* graph = create_csr_graph(node_count, 4 * node_count);
+    int pos = 0;
+    for (int v = 0; v < node_count; v++) {
+        int r = v / side, c = v % side;
+        graph->offsets[v] = pos;
+        if (c > 0) { graph->targets[pos] = v - 1; graph->weights[pos++] = horizontal[v - 1]; }
+        if (c + 1 < side) { graph->targets[pos] = v + 1; graph->weights[pos++] = horizontal[v]; }
+        if (r > 0) { graph->targets[pos] = v - side; graph->weights[pos++] = vertical[v - side]; }
+        if (r + 1 < side) { graph->targets[pos] = v + side; graph->weights[pos++] = vertical[v]; }
     }
-    
+    graph->offsets[node_count] = pos;
+    graph->edge_count = pos;
+
+    free(horizontal);
+    free(vertical);
     return graph;
 }
 
-// Output result as JSON
-void output_result_json(DijkstraResult* result) {
-    printf("{\"path\":[");
-    if (result->path && result->path_length > 0) {
-        for (int i = 0; i < result->path_length; i++) {
-            if (i > 0) printf(",");
-            printf("%d", result->path[i]);
-        }
-    }
-    printf("],\"distance\":%.6f,\"iterations\":%d,\"explored\":[", 
-           result->distance, result->iterations);
-    
-    if (result->explored && result->explored_count > 0) {
-        for (int i = 0; i < result->explored_count; i++) {
-            if (i > 0) printf(",");
-            printf("%d", result->explored[i]);
+// Benchmark one-to-all search on a synthetic grid:
+// sequential heap Dijkstra vs delta-stepping at 1..max_threads threads
+int run_benchmark(int side, double delta, int max_threads) {
+    double build_start = metrics_now();
+    CsrGraph* csr = build_grid_graph(side);
+    metrics_observe(METRIC_PHASE_BUILD, metrics_now() - build_start);
+    int node_count = csr->node_count;
+    printf("Grid %dx%d: %d nodes, %d edges, delta %s\n", side, side, node_count, csr->edge_count,
+           delta > 0.0 ? "fixed" : "auto");
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    DijkstraResult* seq = dijkstra_path_c(csr, NULL, 0, -1, false);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double seq_ms = elapsed_ms(&t0, &t1);
+    printf("%-16s %10.2f ms  (%d settled)\n", "sequential", seq_ms, seq->iterations);
+
+    // Every node's distance must match the sequential search
+    int ok = 1;
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        DeltaSteppingResult* ds = delta_stepping_c(csr, 0, delta, threads);
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        double ms = elapsed_ms(&t0, &t1);
+        int mismatches = 0;
+        for (int v = 0; v < node_count; v++) {
+            double expected = seq->distances[v];
+            double actual = ds->distances[v];
+            if (expected == DBL_MAX || actual == DBL_MAX) {
+                if (expected != actual) mismatches++;
+            } else if (fabs(actual - expected) > 1e-9 * (1.0 + expected)) {
+                mismatches++;
+            }
         }
+        ok = ok && mismatches == 0;
+        printf("delta-step x%-4d %10.2f ms  speedup %.2fx  buckets %d  phases %d  relax %lld",
+               threads, ms, seq_ms / ms, ds->buckets_processed, ds->phases, ds->relaxations);
+        if (mismatches > 0) printf("  MISMATCH at %d nodes", mismatches);
+        printf("\n");
+        free_delta_stepping_result(ds);
     }
-    printf("]}");
+
+    char metrics_text[16384];
+    metrics_format_prometheus(metrics_text, sizeof(metrics_text));
+    printf("\n%s", metrics_text);
+
+    free_dijkstra_result(seq);
+    free_csr_graph(csr);
+    return ok ? 0 : 1;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc != 4) {
-        fprintf(stderr, "Usage: %s <start_node> <end_node> <with_steps>\n", argv[0]);
-        return 1;
+    if (argc >= 2 && strcmp(argv[1], "--bench") == 0) {
+        int side = argc > 2 ? atoi(argv[2]) : 1000;
+        double delta = argc > 3 ? atof(argv[3]) : 0.0;
+        int max_threads = argc > 4 ? atoi(argv[4]) : 8;
+        return run_benchmark(side, delta, max_threads);
     }
-    
-    int start = atoi(argv[1]);
-    int end = atoi(argv[2]);
-    bool with_steps = (atoi(argv[3]) != 0);
-    
-    int node_count;
-    Node* graph = parse_graph_from_json(&node_count);
-    
-    if (!graph) {
-        fprintf(stderr, "Failed to parse graph\n");
-        return 1;
+
+    if (argc == 4 && strcmp(argv[1], "--serve") == 0) {
+        return run_route_worker(argv[2], argv[3]);
     }
-    
-    DijkstraResult* result = dijkstra_path_c(graph, node_count, start, end, with_steps);
-    
-    output_result_json(result);
-    
-    free_dijkstra_result(result);
-    free_graph(graph, node_count);
-    
-    return 0;
+
+    fprintf(stderr, "Usage: %s --serve <socket_path> <graph.bin>\n", argv[0]);
+    fprintf(stderr, "       %s --bench [grid_side] [delta_km] [max_threads]\n", argv[0]);
+    return 1;
 }
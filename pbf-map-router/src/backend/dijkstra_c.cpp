@@ -99,7 +99,11 @@ void heap_sink_down(PriorityQueue* pq, int index) {
 }
 
 void heap_push(PriorityQueue* pq, int node, double distance) {
-    if (pq->size >= pq->capacity) return;
+    if (pq->size >= pq->capacity) {
+        // Lazy deletion can push up to one entry per edge
+        pq->capacity = pq->capacity ? pq->capacity * 2 : 16;
+        pq->heap = (HeapNode*)realloc(pq->heap, sizeof(HeapNode) * pq->capacity);
+    }
     pq->heap[pq->size].node = node;
     pq->heap[pq->size].distance = distance;
     heap_bubble_up(pq, pq->size);
@@ -0,0 +1,34 @@
+#ifndef DIJKSTRA_C_H
+#define DIJKSTRA_C_H
+
+#include <stdbool.h>
+
+#include "csr_graph.h"
+#include "edge_weights.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Dijkstra result structure
+typedef struct DijkstraResult {
+    int* path;
+    int path_length;
+    double distance;
+    int* explored;
+    int explored_count;
+    int iterations;
+    double* distances;   // full search only: per-node distance, DBL_MAX if unreachable
+} DijkstraResult;
+
+// Point-to-point search; weights may be NULL to use graph->weights.
+// end = -1 searches the whole graph and keeps every node's distance.
+DijkstraResult* dijkstra_path_c(const CsrGraph* graph, const WeightSnapshot* weights,
+                                int start, int end, bool with_steps);
+void free_dijkstra_result(DijkstraResult* result);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,94 @@
+// Live edge-weight overrides (closures, traffic) layered over the base
+// graph without rebuilding it. Each batch publishes a new immutable
+// snapshot; a query reads whichever snapshot was current when it started.
+//
+// snapshot.overrides: Map<fromId, Map<toId, weight>>. Publishing copies
+// the outer map and only the inner maps the batch touches.
+
+const CLOSED = Infinity;
+
+class EdgeWeightStore {
+  constructor() {
+    this.current = { epoch: 0, overrides: new Map(), count: 0 };
+  }
+
+  snapshot() {
+    return this.current;
+  }
+
+  // updates: [{ from, to, weight?, closed?, reset?, bidirectional? }]
+  // Edges missing from `graph` are skipped and reported back.
+  apply(graph, updates) {
+    const base = this.current;
+    const overrides = new Map(base.overrides);
+    const copied = new Set();
+    let count = base.count;
+    let applied = 0;
+    const skipped = [];
+
+    const setWeight = (from, to, update) => {
+      const edges = graph[from];
+      if (!edges || !edges.some(edge => edge.to === to)) return false;
+
+      // Empty maps are pruned after the batch, so a later update in the
+      // same batch can still find the copy made here
+      if (!copied.has(from)) {
+        overrides.set(from, new Map(overrides.get(from)));
+        copied.add(from);
+      }
+      const nodeOverrides = overrides.get(from);
+      const had = nodeOverrides.has(to);
+
+      if (update.reset) {
+        nodeOverrides.delete(to);
+        if (had) count--;
+      } else {
+        nodeOverrides.set(to, update.closed ? CLOSED : update.weight);
+        if (!had) count++;
+      }
+      return true;
+    };
+
+    updates.forEach((update, idx) => {
+      if (!update || typeof update !== 'object') {
+        skipped.push({ index: idx, reason: 'update must be an object' });
+        return;
+      }
+      const from = update.from != null ? update.from.toString() : null;
+      const to = update.to != null ? update.to.toString() : null;
+
+      if (!from || !to) {
+        skipped.push({ index: idx, reason: 'from and to required' });
+        return;
+      }
+      if (!update.reset && !update.closed && !(typeof update.weight === 'number' && update.weight >= 0)) {
+        skipped.push({ index: idx, reason: 'weight, closed or reset required' });
+        return;
+      }
+
+      let ok = setWeight(from, to, update);
+      if (update.bidirectional !== false) {
+        ok = setWeight(to, from, update) || ok;
+      }
+      if (ok) {
+        applied++;
+      } else {
+        skipped.push({ index: idx, reason: 'edge not in graph' });
+      }
+    });
+
+    copied.forEach(from => {
+      if (overrides.get(from).size === 0) overrides.delete(from);
+    });
+
+    this.current = { epoch: base.epoch + 1, overrides, count };
+    return { epoch: this.current.epoch, applied, skipped, overrideCount: count };
+  }
+
+  clear() {
+    this.current = { epoch: this.current.epoch + 1, overrides: new Map(), count: 0 };
+    return this.current.epoch;
+  }
+}
+
+module.exports = { EdgeWeightStore, CLOSED };
@@ -0,0 +1,127 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "edge_weights.h"
+
+static WeightSnapshot* create_snapshot(const CsrGraph* base, long long epoch) {
+    WeightSnapshot* snapshot = (WeightSnapshot*)malloc(sizeof(WeightSnapshot));
+    snapshot->epoch = epoch;
+    snapshot->page_count = (base->edge_count + WEIGHT_PAGE_SIZE - 1) >> WEIGHT_PAGE_SHIFT;
+    snapshot->refs = 1;
+    snapshot->base_weights = base->weights;
+    snapshot->pages = (WeightPage**)calloc(snapshot->page_count > 0 ? snapshot->page_count : 1, sizeof(WeightPage*));
+    return snapshot;
+}
+
+// Caller holds layer->lock
+static void free_snapshot_locked(WeightSnapshot* snapshot) {
+    for (int p = 0; p < snapshot->page_count; p++) {
+        WeightPage* page = snapshot->pages[p];
+        if (page && --page->refs == 0) free(page);
+    }
+    free(snapshot->pages);
+    free(snapshot);
+}
+
+WeightLayer* create_weight_layer(const CsrGraph* base) {
+    WeightLayer* layer = (WeightLayer*)malloc(sizeof(WeightLayer));
+    layer->base = base;
+    layer->current = create_snapshot(base, 0);
+    pthread_mutex_init(&layer->lock, NULL);
+    pthread_mutex_init(&layer->write_lock, NULL);
+    return layer;
+}
+
+void free_weight_layer(WeightLayer* layer) {
+    if (layer) {
+        pthread_mutex_lock(&layer->lock);
+        if (--layer->current->refs == 0) free_snapshot_locked(layer->current);
+        pthread_mutex_unlock(&layer->lock);
+        pthread_mutex_destroy(&layer->lock);
+        pthread_mutex_destroy(&layer->write_lock);
+        free(layer);
+    }
+}
+
+WeightSnapshot* weight_layer_acquire(WeightLayer* layer) {
+    pthread_mutex_lock(&layer->lock);
+    WeightSnapshot* snapshot = layer->current;
+    snapshot->refs++;
+    pthread_mutex_unlock(&layer->lock);
+    return snapshot;
+}
+
+void weight_layer_release(WeightLayer* layer, WeightSnapshot* snapshot) {
+    pthread_mutex_lock(&layer->lock);
+    if (--snapshot->refs == 0) free_snapshot_locked(snapshot);
+    pthread_mutex_unlock(&layer->lock);
+}
+
+// Negative or NaN weights would break Dijkstra and the delta-stepping buckets
+static int valid_update_weight(double weight) {
+    return (isfinite(weight) && weight >= 0.0) || weight == EDGE_WEIGHT_CLOSED || weight == EDGE_WEIGHT_RESET;
+}
+
+long long weight_layer_apply(WeightLayer* layer, const EdgeWeightUpdate* updates, int count, int* applied) {
+    const CsrGraph* base = layer->base;
+    int changed = 0;
+
+    if (applied) *applied = 0;
+    for (int u = 0; u < count; u++) {
+        if (!valid_update_weight(updates[u].weight)) return -1;
+    }
+
+    pthread_mutex_lock(&layer->write_lock);
+    WeightSnapshot* old = weight_layer_acquire(layer);
+    WeightSnapshot* next = create_snapshot(base, old->epoch + 1);
+    memcpy(next->pages, old->pages, sizeof(WeightPage*) * old->page_count);
+
+    // Private copies of every touched page, made once per batch
+    char* owned = (char*)calloc(next->page_count > 0 ? next->page_count : 1, 1);
+
+    for (int u = 0; u < count; u++) {
+        int from = updates[u].from;
+        if (from < 0 || from >= base->node_count) continue;
+
+        for (int e = base->offsets[from]; e < base->offsets[from + 1]; e++) {
+            if (base->targets[e] != updates[u].to) continue;
+
+            int p = e >> WEIGHT_PAGE_SHIFT;
+            if (!owned[p]) {
+                WeightPage* copy = (WeightPage*)malloc(sizeof(WeightPage));
+                if (old->pages[p]) {
+                    memcpy(copy->weights, old->pages[p]->weights, sizeof(copy->weights));
+                } else {
+                    int first = p << WEIGHT_PAGE_SHIFT;
+                    int len = base->edge_count - first < WEIGHT_PAGE_SIZE ? base->edge_count - first : WEIGHT_PAGE_SIZE;
+                    memcpy(copy->weights, base->weights + first, sizeof(double) * len);
+                }
+                copy->refs = 1;
+                next->pages[p] = copy;
+                owned[p] = 1;
+            }
+
+            double weight = updates[u].weight == EDGE_WEIGHT_RESET ? base->weights[e] : updates[u].weight;
+            next->pages[p]->weights[e & WEIGHT_PAGE_MASK] = weight;
+            changed++;
+        }
+    }
+
+    // Share the untouched pages, then publish the new epoch
+    pthread_mutex_lock(&layer->lock);
+    for (int p = 0; p < next->page_count; p++) {
+        if (!owned[p] && next->pages[p]) next->pages[p]->refs++;
+    }
+    long long epoch = next->epoch;
+    WeightSnapshot* previous = layer->current;
+    layer->current = next;
+    if (--previous->refs == 0) free_snapshot_locked(previous);
+    pthread_mutex_unlock(&layer->lock);
+
+    weight_layer_release(layer, old);
+    pthread_mutex_unlock(&layer->write_lock);
+    free(owned);
+
+    if (applied) *applied = changed;
+    return epoch;
+}
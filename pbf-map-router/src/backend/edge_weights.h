@@ -0,0 +1,74 @@
+#ifndef EDGE_WEIGHTS_H
+#define EDGE_WEIGHTS_H
+
+#include <math.h>
+#include <pthread.h>
+
+#include "csr_graph.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Weights live in pages of WEIGHT_PAGE_SIZE edges. A snapshot shares
+// untouched pages with its predecessor; a NULL page means "base weights".
+#define WEIGHT_PAGE_SHIFT 12
+#define WEIGHT_PAGE_SIZE (1 << WEIGHT_PAGE_SHIFT)
+#define WEIGHT_PAGE_MASK (WEIGHT_PAGE_SIZE - 1)
+
+// Special values for EdgeWeightUpdate.weight
+#define EDGE_WEIGHT_CLOSED HUGE_VAL
+#define EDGE_WEIGHT_RESET (-1.0)
+
+typedef struct WeightPage {
+    int refs;                      // snapshots sharing this page
+    double weights[WEIGHT_PAGE_SIZE];
+} WeightPage;
+
+// Immutable view of all edge weights at one epoch
+typedef struct WeightSnapshot {
+    long long epoch;
+    int page_count;
+    int refs;
+    const double* base_weights;
+    WeightPage** pages;
+} WeightSnapshot;
+
+typedef struct WeightLayer {
+    const CsrGraph* base;
+    WeightSnapshot* current;
+    pthread_mutex_t lock;          // guards `current` and snapshot refcounts
+    pthread_mutex_t write_lock;    // serialises writers
+} WeightLayer;
+
+// Override for every from -> to edge. weight must be finite and >= 0,
+// EDGE_WEIGHT_CLOSED to close the edge, or EDGE_WEIGHT_RESET to restore
+// the base weight.
+typedef struct EdgeWeightUpdate {
+    int from;
+    int to;
+    double weight;
+} EdgeWeightUpdate;
+
+WeightLayer* create_weight_layer(const CsrGraph* base);
+void free_weight_layer(WeightLayer* layer);
+
+// Pin the current snapshot; queries read it without further locking
+WeightSnapshot* weight_layer_acquire(WeightLayer* layer);
+void weight_layer_release(WeightLayer* layer, WeightSnapshot* snapshot);
+
+// Apply a batch as one new epoch. Only pages holding updated edges are
+// copied. Returns the new epoch; *applied gets the number of edges changed.
+// If any weight is invalid nothing is applied and -1 is returned.
+long long weight_layer_apply(WeightLayer* layer, const EdgeWeightUpdate* updates, int count, int* applied);
+
+static inline double weight_snapshot_get(const WeightSnapshot* snapshot, int edge) {
+    WeightPage* page = snapshot->pages[edge >> WEIGHT_PAGE_SHIFT];
+    return page ? page->weights[edge & WEIGHT_PAGE_MASK] : snapshot->base_weights[edge];
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,137 @@
+const fs = require('fs');
+
+// Mirrors load_csr_graph() in csr_graph.c:
+//   "CSRG", int32 version, int32 nodeCount, int32 edgeCount,
+//   int32 offsets[nodeCount + 1], int32 targets[edgeCount], float64 weights[edgeCount]
+const MAGIC = 'CSRG';
+const VERSION = 1;
+
+// Nodes (or way refs) rebuilt per event-loop turn when unpacking on the main thread
+const UNPACK_SLICE = 20000;
+
+// Flatten parsed nodes, ways and the adjacency graph into typed arrays so the
+// loader thread can hand them over without a structured clone. Node i has
+// OSM id ids[i] and edges [offsets[i], offsets[i + 1]) in CSR order.
+function packGraph(nodes, ways, graph) {
+  const nodeKeys = Object.keys(nodes);
+  const index = new Map();
+  nodeKeys.forEach((id, i) => index.set(id, i));
+
+  const ids = new Float64Array(nodeKeys.length);
+  const lat = new Float64Array(nodeKeys.length);
+  const lon = new Float64Array(nodeKeys.length);
+  let edgeCount = 0;
+  nodeKeys.forEach((id, i) => {
+    ids[i] = Number(id);
+    lat[i] = nodes[id].lat;
+    lon[i] = nodes[id].lon;
+    if (graph[id]) edgeCount += graph[id].length;
+  });
+
+  const offsets = new Int32Array(nodeKeys.length + 1);
+  const targets = new Int32Array(edgeCount);
+  const weights = new Float64Array(edgeCount);
+  let pos = 0;
+  nodeKeys.forEach((id, i) => {
+    offsets[i] = pos;
+    (graph[id] || []).forEach(edge => {
+      targets[pos] = index.get(edge.to);
+      weights[pos] = edge.dist;
+      pos++;
+    });
+  });
+  offsets[nodeKeys.length] = pos;
+
+  let refCount = 0;
+  ways.forEach(way => { refCount += way.nodes.length; });
+  const wayIds = new Float64Array(ways.length);
+  const wayOffsets = new Int32Array(ways.length + 1);
+  const wayRefs = new Float64Array(refCount);
+  pos = 0;
+  ways.forEach((way, i) => {
+    wayIds[i] = Number(way.id);
+    wayOffsets[i] = pos;
+    way.nodes.forEach(ref => { wayRefs[pos++] = Number(ref); });
+  });
+  wayOffsets[ways.length] = pos;
+
+  return { ids, lat, lon, offsets, targets, weights, wayIds, wayOffsets, wayRefs };
+}
+
+// ArrayBuffers to list as transferables when posting a packed graph
+function packedBuffers(packed) {
+  return Object.values(packed).map(array => array.buffer);
+}
+
+// Rebuild { nodes, ways, graph, nodeIds } from a packed graph, yielding to
+// the event loop between slices so requests keep being served meanwhile
+async function unpackGraph(packed, onProgress) {
+  const { ids, lat, lon, offsets, targets, weights, wayIds, wayOffsets, wayRefs } = packed;
+  const nodeCount = ids.length;
+  const nodeIds = new Array(nodeCount);
+  const nodes = {};
+  const graph = {};
+  const ways = new Array(wayIds.length);
+  const yieldToLoop = () => new Promise(resolve => setImmediate(resolve));
+
+  // Ids first: edges refer to nodes in later slices
+  for (let begin = 0; begin < nodeCount; begin += UNPACK_SLICE * 10) {
+    const end = Math.min(begin + UNPACK_SLICE * 10, nodeCount);
+    for (let i = begin; i < end; i++) nodeIds[i] = String(ids[i]);
+    await yieldToLoop();
+  }
+
+  for (let begin = 0; begin < nodeCount; begin += UNPACK_SLICE) {
+    const end = Math.min(begin + UNPACK_SLICE, nodeCount);
+    for (let i = begin; i < end; i++) {
+      const id = nodeIds[i];
+      nodes[id] = { id, lat: lat[i], lon: lon[i] };
+      if (offsets[i + 1] > offsets[i]) {
+        const edges = new Array(offsets[i + 1] - offsets[i]);
+        for (let e = offsets[i]; e < offsets[i + 1]; e++) {
+          edges[e - offsets[i]] = { to: nodeIds[targets[e]], dist: weights[e] };
+        }
+        graph[id] = edges;
+      }
+    }
+    if (onProgress) onProgress({ phase: 'unpack-nodes', processed: end, total: nodeCount });
+    await yieldToLoop();
+  }
+
+  let i = 0;
+  while (i < ways.length) {
+    const refLimit = wayOffsets[i] + UNPACK_SLICE;
+    do {
+      ways[i] = { id: wayIds[i], nodes: Array.from(wayRefs.subarray(wayOffsets[i], wayOffsets[i + 1])) };
+      i++;
+    } while (i < ways.length && wayOffsets[i] < refLimit);
+    if (onProgress) onProgress({ phase: 'unpack-ways', processed: i, total: ways.length });
+    await yieldToLoop();
+  }
+
+  return { nodes, ways, graph, nodeIds };
+}
+
+// Write a packed graph as a CSR file for the native route workers.
+// Node indexes in the file match the packed order.
+function writeGraphBinary(packed, filePath) {
+  const { ids, offsets, targets, weights } = packed;
+
+  const header = Buffer.alloc(16);
+  header.write(MAGIC, 0, 'ascii');
+  header.writeInt32LE(VERSION, 4);
+  header.writeInt32LE(ids.length, 8);
+  header.writeInt32LE(targets.length, 12);
+
+  const fd = fs.openSync(filePath, 'w');
+  try {
+    fs.writeSync(fd, header);
+    fs.writeSync(fd, Buffer.from(offsets.buffer, offsets.byteOffset, offsets.byteLength));
+    fs.writeSync(fd, Buffer.from(targets.buffer, targets.byteOffset, targets.byteLength));
+    fs.writeSync(fd, Buffer.from(weights.buffer, weights.byteOffset, weights.byteLength));
+  } finally {
+    fs.closeSync(fd);
+  }
+}
+
+module.exports = { packGraph, packedBuffers, unpackGraph, writeGraphBinary };
@@ -0,0 +1,127 @@
+const v8 = require('v8');
+const { Worker, isMainThread, parentPort, workerData } = require('worker_threads');
+
+const { parsePBFFile } = require('./pbfParser');
+const { buildGraph } = require('./routeFinder');
+const { packGraph, packedBuffers, unpackGraph, writeGraphBinary } = require('./graphBinary');
+const metrics = require('./metrics');
+
+function computeBounds(nodes) {
+  let minLat = Infinity, maxLat = -Infinity;
+  let minLon = Infinity, maxLon = -Infinity;
+
+  const nodeValues = Object.values(nodes);
+  if (nodeValues.length === 0) return null;
+
+  nodeValues.forEach(node => {
+    if (node.lat < minLat) minLat = node.lat;
+    if (node.lat > maxLat) maxLat = node.lat;
+    if (node.lon < minLon) minLon = node.lon;
+    if (node.lon > maxLon) maxLon = node.lon;
+  });
+
+  return {
+    minLat: minLat,
+    maxLat: maxLat,
+    minLon: minLon,
+    maxLon: maxLon,
+    centerLat: (minLat + maxLat) / 2,
+    centerLon: (minLon + maxLon) / 2
+  };
+}
+
+async function runLoad(filePath, binaryPath) {
+  const report = progress => parentPort.postMessage({ type: 'progress', progress });
+
+  const parseStart = metrics.now();
+  const parsed = await parsePBFFile(filePath, report);
+  const buildStart = metrics.now();
+  const graph = buildGraph(parsed.nodes, parsed.ways, report);
+
+  // Cloning the object graph would stall the main thread for seconds on
+  // large maps, so hand over typed arrays instead (moved, not copied)
+  report({ phase: 'pack' });
+  const packed = packGraph(parsed.nodes, parsed.ways, graph);
+  if (binaryPath) {
+    report({ phase: 'write-binary' });
+    writeGraphBinary(packed, binaryPath);
+  }
+  const buildEnd = metrics.now();
+  report({ phase: 'transfer' });
+
+  parentPort.postMessage({
+    type: 'done',
+    data: {
+      packed: packed,
+      bounds: computeBounds(parsed.nodes),
+      timings: { parse: buildStart - parseStart, build: buildEnd - buildStart }
+    }
+  }, packedBuffers(packed));
+}
+
+// Parse and build the graph on a worker thread so the server keeps
+// answering queries against the current graph in the meantime. The
+// result is rebuilt into JS objects on this thread in small slices.
+// With binaryPath set, also write the graph there for the route workers;
+// the returned nodeIds give the node id at each index of that file.
+async function loadGraphInBackground(filePath, onProgress, binaryPath = null) {
+  const data = await runLoaderThread(filePath, onProgress, binaryPath);
+
+  const unpackStart = metrics.now();
+  const unpacked = await unpackGraph(data.packed, onProgress);
+  metrics.observe('build', data.timings.build + metrics.now() - unpackStart);
+
+  return {
+    nodes: unpacked.nodes,
+    ways: unpacked.ways,
+    graph: unpacked.graph,
+    nodeIds: unpacked.nodeIds,
+    bounds: data.bounds
+  };
+}
+
+function runLoaderThread(filePath, onProgress, binaryPath) {
+  return new Promise((resolve, reject) => {
+    // Workers do not inherit --max-old-space-size, so pass the main heap limit on
+    const heapLimitMb = Math.floor(v8.getHeapStatistics().heap_size_limit / 1024 / 1024);
+    const worker = new Worker(__filename, {
+      workerData: { graphLoader: true, filePath, binaryPath },
+      resourceLimits: { maxOldGenerationSizeMb: heapLimitMb }
+    });
+
+    let settled = false;
+    worker.on('message', msg => {
+      if (msg.type === 'progress') {
+        if (onProgress) onProgress(msg.progress);
+      } else if (msg.type === 'done') {
+        settled = true;
+        // Worker threads have their own metrics instance, so record here
+        metrics.observe('parse', msg.data.timings.parse);
+        resolve(msg.data);
+      } else if (msg.type === 'error') {
+        settled = true;
+        reject(new Error(msg.message));
+      }
+    });
+    worker.on('error', err => {
+      if (!settled) {
+        settled = true;
+        reject(err);
+      }
+    });
+    worker.on('exit', code => {
+      if (!settled) {
+        settled = true;
+        reject(new Error(`Graph loader exited with code ${code}`));
+      }
+    });
+  });
+}
+
+if (!isMainThread && workerData && workerData.graphLoader) {
+  runLoad(workerData.filePath, workerData.binaryPath).catch(err => {
+    parentPort.postMessage({ type: 'error', message: err.message });
+  });
+}
+
+module.exports = { loadGraphInBackground };
@@ -0,0 +1,40 @@
+// Holds the live map graph behind a reference-counted handle so a new
+// graph can be published while queries are still running on the old one.
+class GraphStore {
+  constructor(initialData, onDispose) {
+    this.version = 0;
+    this.onDispose = onDispose;
+    this.current = this._createHandle(initialData);
+  }
+
+  _createHandle(data) {
+    // The store itself holds one reference until the handle is replaced
+    return { data, version: this.version++, refs: 1, retired: false };
+  }
+
+  acquire() {
+    const handle = this.current;
+    handle.refs++;
+    return handle;
+  }
+
+  release(handle) {
+    handle.refs--;
+    if (handle.refs === 0 && handle.retired) {
+      const { version, data } = handle;
+      handle.data = null;
+      if (this.onDispose) this.onDispose(version, data);
+    }
+  }
+
+  // Swap in a new graph; the old one is freed once its last reader releases it
+  publish(data) {
+    const old = this.current;
+    this.current = this._createHandle(data);
+    old.retired = true;
+    this.release(old);
+    return this.current.version;
+  }
+}
+
+module.exports = { GraphStore };
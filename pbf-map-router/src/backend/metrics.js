@@ -0,0 +1,99 @@
+// Counters and per-phase latency histograms for the routing hot path,
+// rendered in Prometheus text format by /api/metrics.
+// Same bucket layout as route_metrics.c: bucket i is <= 2^i microseconds.
+
+const HISTOGRAM_BUCKETS = 24;
+
+const COUNTERS = {
+  heap_pushes: 'Priority queue pushes during route searches',
+  heap_pops: 'Priority queue pops during route searches',
+  relaxations: 'Edge relaxations during route searches',
+  stale_pops: 'Popped entries that were already settled',
+  settled_nodes: 'Nodes settled by route searches',
+  routes: 'Route queries answered'
+};
+
+const PHASES = ['parse', 'build', 'search', 'path', 'serialize'];
+
+const counters = {};
+Object.keys(COUNTERS).forEach(name => { counters[name] = 0; });
+
+const histograms = {};
+PHASES.forEach(phase => {
+  histograms[phase] = {
+    buckets: new Array(HISTOGRAM_BUCKETS + 1).fill(0),
+    count: 0,
+    sum: 0
+  };
+});
+
+const collectors = [];
+
+function add(name, value = 1) {
+  counters[name] += value;
+}
+
+function observe(phase, seconds) {
+  const hist = histograms[phase];
+  const micros = seconds * 1e6;
+  let bucket = 0;
+  let bound = 1;
+  while (bucket < HISTOGRAM_BUCKETS && micros > bound) {
+    bound *= 2;
+    bucket++;
+  }
+  hist.buckets[bucket]++;
+  hist.count++;
+  hist.sum += seconds;
+}
+
+function now() {
+  return Number(process.hrtime.bigint()) / 1e9;
+}
+
+// Extra text sources (e.g. native workers) appended to the output;
+// fn may return a string or a promise of one
+function addCollector(fn) {
+  collectors.push(fn);
+}
+
+async function render() {
+  const lines = [];
+
+  Object.keys(COUNTERS).forEach(name => {
+    lines.push(`# HELP router_${name}_total ${COUNTERS[name]}`);
+    lines.push(`# TYPE router_${name}_total counter`);
+    lines.push(`router_${name}_total ${counters[name]}`);
+  });
+
+  lines.push('# HELP router_phase_seconds Time spent per routing phase');
+  lines.push('# TYPE router_phase_seconds histogram');
+  PHASES.forEach(phase => {
+    const hist = histograms[phase];
+    let cumulative = 0;
+    let bound = 1e-6;
+    for (let i = 0; i < HISTOGRAM_BUCKETS; i++) {
+      cumulative += hist.buckets[i];
+      lines.push(`router_phase_seconds_bucket{phase="${phase}",le="${bound}"} ${cumulative}`);
+      bound *= 2;
+    }
+    cumulative += hist.buckets[HISTOGRAM_BUCKETS];
+    lines.push(`router_phase_seconds_bucket{phase="${phase}",le="+Inf"} ${cumulative}`);
+    lines.push(`router_phase_seconds_sum{phase="${phase}"} ${hist.sum}`);
+    lines.push(`router_phase_seconds_count{phase="${phase}"} ${hist.count}`);
+  });
+
+  const memory = process.memoryUsage();
+  lines.push('# HELP router_heap_used_bytes V8 heap in use');
+  lines.push('# TYPE router_heap_used_bytes gauge');
+  lines.push(`router_heap_used_bytes ${memory.heapUsed}`);
+
+  let text = lines.join('\n') + '\n';
+  for (const fn of collectors) {
+    const extra = await fn();
+    if (extra) text += extra;
+  }
+  return text;
+}
+
+module.exports = { add, observe, now, addCollector, render };
@@ -1,7 +1,7 @@
 const fs = require('fs');
 const path = require('path');
 
-async function parsePBFFile(filePath) {
+async function parsePBFFile(filePath, onProgress) {
   const { createOSMStream } = await import('osm-pbf-parser-node');
 
   const nodeRefs = new Set();
@@ -30,6 +30,7 @@ async function parsePBFFile(filePath) {
         
         if (wayCounter % 10000 === 0) {
           console.log(`  🛣️  Scanned ${wayCounter.toLocaleString()} ways...`);
+          if (onProgress) onProgress({ phase: 'scan-ways', processed: wayCounter });
         }
 
         if (item.refs && item.refs.length >= 2) {
@@ -65,6 +66,7 @@ async function parsePBFFile(filePath) {
         if (nodeCounter % 100000 === 0) {
           const elapsed = ((Date.now() - startTime) / 1000).toFixed(1);
           console.log(`  📍 Scanned ${nodeCounter.toLocaleString()} nodes, loaded ${nodesLoaded.toLocaleString()} used nodes (${elapsed}s)`);
+          if (onProgress) onProgress({ phase: 'load-nodes', processed: nodeCounter, loaded: nodesLoaded });
         }
       }
     }
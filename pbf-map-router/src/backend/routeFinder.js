@@ -1,4 +1,6 @@
-function buildGraph(nodes, ways) {
+const metrics = require('./metrics');
+
+function buildGraph(nodes, ways, onProgress) {
   console.log('🔗 Building graph...');
   const startTime = Date.now();
   const graph = {};
@@ -10,6 +12,7 @@ function buildGraph(nodes, ways) {
     if (idx % 10000 === 0 && idx > 0) {
       const elapsed = ((Date.now() - startTime) / 1000).toFixed(1);
       console.log(`  Processing way ${idx.toLocaleString()}/${ways.length.toLocaleString()}... (${elapsed}s)`);
+      if (onProgress) onProgress({ phase: 'build-graph', processed: idx, total: ways.length });
     }
 
     for (let i = 0; i < way.nodes.length - 1; i++) {
@@ -52,11 +55,12 @@ function calculateDistance(node1, node2) {
   return R * c;
 }
 
-function dijkstraPath(graph, start, end, withSteps = false) {
-  return dijkstraPathJS(graph, start, end, withSteps);
+function dijkstraPath(graph, start, end, withSteps = false, weights = null) {
+  return dijkstraPathJS(graph, start, end, withSteps, weights);
 }
 
-function dijkstraPathJS(graph, start, end, withSteps = false) {
+// weights: optional EdgeWeightStore snapshot whose overrides replace edge dists
+function dijkstraPathJS(graph, start, end, withSteps = false, weights = null) {
   const distances = {};
   const previous = {};
   const visited = new Set();
@@ -64,6 +68,8 @@ function dijkstraPathJS(graph, start, end, withSteps = false) {
   const allVisitedEdges = [];
   const waveFront = [];
   const updated = [];
+  const searchStart = metrics.now();
+  let pushes = 1, staleCount = 0, relaxations = 0;
 
   Object.keys(graph).forEach(node => {
     distances[node] = Infinity;
@@ -84,7 +90,10 @@ function dijkstraPathJS(graph, start, end, withSteps = false) {
     iterations++;
     const { element: current } = heap.dequeue();
 
-    if (visited.has(current)) continue;
+    if (visited.has(current)) {
+      staleCount++;
+      continue;
+    }
     visited.add(current);
 
     if (withSteps) {
@@ -122,13 +131,18 @@ function dijkstraPathJS(graph, start, end, withSteps = false) {
 
     if (!graph[current]) continue;
 
+    const nodeOverrides = weights && weights.overrides.get(current);
+
     graph[current].forEach(neighbor => {
-      const alt = distances[current] + neighbor.dist;
+      const dist = nodeOverrides && nodeOverrides.has(neighbor.to) ? nodeOverrides.get(neighbor.to) : neighbor.dist;
+      const alt = distances[current] + dist;
+      relaxations++;
       
       if (alt < distances[neighbor.to]) {
         distances[neighbor.to] = alt;
         previous[neighbor.to] = current;
         heap.enqueue(neighbor.to, alt);
+        pushes++;
         
         if (withSteps) {
           updated.push({
@@ -158,6 +172,14 @@ function dijkstraPathJS(graph, start, end, withSteps = false) {
     }
   }
 
+  const pathStart = metrics.now();
+  metrics.observe('search', pathStart - searchStart);
+  metrics.add('heap_pushes', pushes);
+  metrics.add('heap_pops', iterations);
+  metrics.add('stale_pops', staleCount);
+  metrics.add('relaxations', relaxations);
+  metrics.add('settled_nodes', visited.size);
+
   const path = [];
   let current = end;
   
@@ -165,6 +187,7 @@ function dijkstraPathJS(graph, start, end, withSteps = false) {
     path.unshift(current);
     current = previous[current];
   }
+  metrics.observe('path', metrics.now() - pathStart);
 
   return {
     path: path.length > 1 && distances[end] !== Infinity ? path : null,
@@ -0,0 +1,286 @@
+const { spawn } = require('child_process');
+const net = require('net');
+
+// Client side of the protocol in route_worker.h. Each frame starts with
+// uint32 payloadLength, uint32 requestId, uint8 type, uint8 status, uint16 reserved.
+const HEADER_SIZE = 12;
+
+const MSG = {
+  ROUTE: 1,
+  ONE_TO_ALL: 2,
+  WEIGHTS: 3,
+  METRICS: 4,
+  INFO: 5
+};
+
+const STATUS = {
+  OK: 0,
+  BAD_REQUEST: 1,
+  NO_PATH: 2
+};
+
+function readInt32Array(buf, offset, count) {
+  const out = new Array(count);
+  for (let i = 0; i < count; i++) out[i] = buf.readInt32LE(offset + i * 4);
+  return out;
+}
+
+// One native worker process plus the socket connection to it
+class RouteWorker {
+  constructor(binPath, graphPath, socketPath) {
+    this.binPath = binPath;
+    this.graphPath = graphPath;
+    this.socketPath = socketPath;
+    this.pending = new Map();
+    this.nextId = 1;
+    // Received chunks not yet consumed; joined only once a whole frame is in
+    this.chunks = [];
+    this.bufferedLength = 0;
+    this.corked = false;
+    this.closed = false;
+  }
+
+  start() {
+    return new Promise((resolve, reject) => {
+      // The worker exits when its stdin closes, so it never outlives us
+      this.proc = spawn(this.binPath, ['--serve', this.socketPath, this.graphPath], {
+        stdio: ['pipe', 'pipe', 'inherit']
+      });
+
+      let started = false;
+      this.proc.on('error', err => {
+        if (!started) reject(err);
+      });
+      this.proc.on('exit', code => {
+        this.closed = true;
+        if (!started) reject(new Error(`Route worker exited with code ${code}`));
+        this._failPending(new Error(`Route worker exited with code ${code}`));
+      });
+
+      let output = '';
+      this.proc.stdout.on('data', chunk => {
+        if (started) return;
+        output += chunk.toString();
+        if (!output.includes('\n')) return;
+
+        started = true;
+        this.socket = net.createConnection(this.socketPath);
+        this.socket.on('connect', () => resolve(this));
+        this.socket.on('data', data => this._onData(data));
+        this.socket.on('error', err => {
+          reject(err);
+          this._failPending(err);
+        });
+        this.socket.on('close', () => {
+          this.closed = true;
+          this._failPending(new Error('Route worker connection closed'));
+        });
+      });
+    });
+  }
+
+  get pendingCount() {
+    return this.pending.size;
+  }
+
+  request(type, payload = Buffer.alloc(0)) {
+    if (this.closed) return Promise.reject(new Error('Route worker is not running'));
+
+    const id = this.nextId++;
+    const header = Buffer.alloc(HEADER_SIZE);
+    header.writeUInt32LE(payload.length, 0);
+    header.writeUInt32LE(id, 4);
+    header.writeUInt8(type, 8);
+
+    // Batch every request issued in this tick into one write
+    if (!this.corked) {
+      this.corked = true;
+      this.socket.cork();
+      process.nextTick(() => {
+        this.corked = false;
+        this.socket.uncork();
+      });
+    }
+    this.socket.write(header);
+    if (payload.length > 0) this.socket.write(payload);
+
+    return new Promise((resolve, reject) => {
+      this.pending.set(id, { type, resolve, reject });
+    });
+  }
+
+  _onData(chunk) {
+    this.chunks.push(chunk);
+    this.bufferedLength += chunk.length;
+
+    while (this.bufferedLength >= HEADER_SIZE) {
+      if (this.chunks[0].length < HEADER_SIZE) this._joinChunks();
+      const length = this.chunks[0].readUInt32LE(0);
+      if (this.bufferedLength < HEADER_SIZE + length) break;
+
+      const frame = this.chunks[0].length >= HEADER_SIZE + length ? this.chunks[0] : this._joinChunks();
+      const id = frame.readUInt32LE(4);
+      const status = frame.readUInt8(9);
+      const payload = frame.subarray(HEADER_SIZE, HEADER_SIZE + length);
+      const rest = frame.subarray(HEADER_SIZE + length);
+      this.bufferedLength -= HEADER_SIZE + length;
+      if (rest.length > 0) {
+        this.chunks[0] = rest;
+      } else {
+        this.chunks.shift();
+      }
+
+      const entry = this.pending.get(id);
+      if (!entry) continue;
+      this.pending.delete(id);
+      if (status === STATUS.BAD_REQUEST) {
+        entry.reject(new Error('Route worker rejected request'));
+        // Queries queued behind a missed weight update would use stale weights
+        if (entry.type === MSG.WEIGHTS) {
+          this.stop();
+          this._failPending(new Error('Route worker missed a weight update'));
+          return;
+        }
+      } else {
+        entry.resolve({ status, payload });
+      }
+    }
+  }
+
+  _joinChunks() {
+    const joined = Buffer.concat(this.chunks, this.bufferedLength);
+    this.chunks = [joined];
+    return joined;
+  }
+
+  _failPending(err) {
+    this.pending.forEach(entry => entry.reject(err));
+    this.pending.clear();
+  }
+
+  stop() {
+    this.closed = true;
+    if (this.socket) this.socket.destroy();
+    if (this.proc && this.proc.stdin) this.proc.stdin.end();
+  }
+}
+
+// A set of workers serving the same binary graph. Queries go to the
+// least-loaded worker; weight updates go to all of them.
+class RouteWorkerPool {
+  constructor({ binPath, graphPath, size, socketPrefix }) {
+    this.workers = [];
+    for (let i = 0; i < size; i++) {
+      this.workers.push(new RouteWorker(binPath, graphPath, `${socketPrefix}-${i}.sock`));
+    }
+  }
+
+  async start() {
+    try {
+      await Promise.all(this.workers.map(worker => worker.start()));
+    } catch (err) {
+      this.close();
+      throw err;
+    }
+    return this;
+  }
+
+  _pick() {
+    let best = null;
+    this.workers.forEach(worker => {
+      if (worker.closed) return;
+      if (!best || worker.pendingCount < best.pendingCount) best = worker;
+    });
+    if (!best) throw new Error('No route workers running');
+    return best;
+  }
+
+  async route(start, end, withSteps = false) {
+    const payload = Buffer.alloc(9);
+    payload.writeInt32LE(start, 0);
+    payload.writeInt32LE(end, 4);
+    payload.writeUInt8(withSteps ? 1 : 0, 8);
+
+    const { status, payload: res } = await this._pick().request(MSG.ROUTE, payload);
+    const pathLength = res.readInt32LE(12);
+    const exploredCount = res.readInt32LE(16);
+    return {
+      found: status === STATUS.OK,
+      distance: res.readDoubleLE(0),
+      iterations: res.readInt32LE(8),
+      path: readInt32Array(res, 20, pathLength),
+      explored: readInt32Array(res, 20 + pathLength * 4, exploredCount)
+    };
+  }
+
+  async oneToAll(start, delta = 0, threads = 1) {
+    const payload = Buffer.alloc(16);
+    payload.writeInt32LE(start, 0);
+    payload.writeDoubleLE(delta, 4);
+    payload.writeInt32LE(threads, 12);
+
+    const { payload: res } = await this._pick().request(MSG.ONE_TO_ALL, payload);
+    const nodeCount = res.readInt32LE(0);
+    // Copy out so the typed arrays are aligned
+    const body = Buffer.from(res.subarray(12));
+    return {
+      buckets: res.readInt32LE(4),
+      phases: res.readInt32LE(8),
+      distances: new Float64Array(body.buffer, body.byteOffset, nodeCount),
+      previous: new Int32Array(body.buffer, body.byteOffset + nodeCount * 8, nodeCount)
+    };
+  }
+
+  // updates: [{ from, to, weight }] by node index; Infinity closes, -1 restores
+  async applyWeights(updates) {
+    const payload = Buffer.alloc(4 + updates.length * 16);
+    payload.writeInt32LE(updates.length, 0);
+    updates.forEach((update, i) => {
+      payload.writeInt32LE(update.from, 4 + i * 16);
+      payload.writeInt32LE(update.to, 8 + i * 16);
+      payload.writeDoubleLE(update.weight, 12 + i * 16);
+    });
+
+    // Dead workers take no queries, so only the running ones need the update
+    const running = this.workers.filter(worker => !worker.closed);
+    if (running.length === 0) throw new Error('No route workers running');
+    const results = await Promise.all(running.map(worker => worker.request(MSG.WEIGHTS, payload)));
+    return results.map(({ payload: res }) => ({
+      epoch: Number(res.readBigInt64LE(0)),
+      applied: res.readInt32LE(8)
+    }));
+  }
+
+  // Prometheus text summed across workers
+  async metrics() {
+    const running = this.workers.filter(worker => !worker.closed);
+    const results = await Promise.all(running.map(worker => worker.request(MSG.METRICS)));
+    return sumPrometheus(results.map(({ payload }) => payload.toString()));
+  }
+
+  close() {
+    this.workers.forEach(worker => worker.stop());
+  }
+}
+
+// Sum samples with identical name and labels; comments come from the first text
+function sumPrometheus(texts) {
+  if (texts.length === 0) return '';
+  const totals = new Map();
+  texts.forEach(text => {
+    text.split('\n').forEach(line => {
+      if (!line || line.startsWith('#')) return;
+      const split = line.lastIndexOf(' ');
+      const key = line.slice(0, split);
+      totals.set(key, (totals.get(key) || 0) + Number(line.slice(split + 1)));
+    });
+  });
+
+  return texts[0].split('\n').map(line => {
+    if (!line || line.startsWith('#')) return line;
+    const key = line.slice(0, line.lastIndexOf(' '));
+    return `${key} ${totals.get(key)}`;
+  }).join('\n');
+}
+
+module.exports = { RouteWorkerPool };
@@ -0,0 +1,128 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "route_metrics.h"
+
+// Threads beyond this share the last slot, which stays correct because
+// every update is an atomic add
+#define METRICS_MAX_THREADS 64
+
+typedef struct MetricsHistogram {
+    atomic_llong buckets[METRIC_HISTOGRAM_BUCKETS + 1];   // last is +Inf
+    atomic_llong count;
+    atomic_llong sum_ns;
+} MetricsHistogram;
+
+typedef struct MetricsSlot {
+    atomic_llong counters[METRIC_COUNTER_COUNT];
+    MetricsHistogram phases[METRIC_PHASE_COUNT];
+} MetricsSlot;
+
+static MetricsSlot slots[METRICS_MAX_THREADS];
+static atomic_int slots_claimed;
+static _Thread_local MetricsSlot* local_slot;
+
+static const char* counter_names[METRIC_COUNTER_COUNT] = {
+    "heap_pushes", "heap_pops", "relaxations", "stale_pops", "settled_nodes", "bytes_allocated"
+};
+
+static const char* counter_help[METRIC_COUNTER_COUNT] = {
+    "Priority queue pushes during route searches",
+    "Priority queue pops during route searches",
+    "Edge relaxations during route searches",
+    "Popped entries that were already settled",
+    "Nodes settled by route searches",
+    "Bytes allocated for search working memory"
+};
+
+static const char* phase_names[METRIC_PHASE_COUNT] = {
+    "parse", "build", "search", "path", "serialize", "load_graph"
+};
+
+static MetricsSlot* get_slot(void) {
+    if (!local_slot) {
+        int index = atomic_fetch_add_explicit(&slots_claimed, 1, memory_order_relaxed);
+        local_slot = &slots[index < METRICS_MAX_THREADS ? index : METRICS_MAX_THREADS - 1];
+    }
+    return local_slot;
+}
+
+void metrics_add(MetricCounter counter, long long value) {
+    atomic_fetch_add_explicit(&get_slot()->counters[counter], value, memory_order_relaxed);
+}
+
+void metrics_observe(MetricPhase phase, double seconds) {
+    MetricsHistogram* hist = &get_slot()->phases[phase];
+    double micros = seconds * 1e6;
+    int bucket = 0;
+    double bound = 1.0;
+    while (bucket < METRIC_HISTOGRAM_BUCKETS && micros > bound) {
+        bound *= 2.0;
+        bucket++;
+    }
+    atomic_fetch_add_explicit(&hist->buckets[bucket], 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->count, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&hist->sum_ns, (long long)(seconds * 1e9), memory_order_relaxed);
+}
+
+double metrics_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// snprintf that keeps counting once the buffer is full
+static void append(char* buffer, size_t size, size_t* pos, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int written = vsnprintf(*pos < size ? buffer + *pos : NULL, *pos < size ? size - *pos : 0, fmt, args);
+    va_end(args);
+    if (written > 0) *pos += written;
+}
+
+size_t metrics_format_prometheus(char* buffer, size_t size) {
+    size_t pos = 0;
+    int used = atomic_load_explicit(&slots_claimed, memory_order_relaxed);
+    if (used > METRICS_MAX_THREADS) used = METRICS_MAX_THREADS;
+    if (size > 0) buffer[0] = '\0';
+
+    for (int c = 0; c < METRIC_COUNTER_COUNT; c++) {
+        long long total = 0;
+        for (int s = 0; s < used; s++) {
+            total += atomic_load_explicit(&slots[s].counters[c], memory_order_relaxed);
+        }
+        append(buffer, size, &pos, "# HELP router_native_%s_total %s\n", counter_names[c], counter_help[c]);
+        append(buffer, size, &pos, "# TYPE router_native_%s_total counter\n", counter_names[c]);
+        append(buffer, size, &pos, "router_native_%s_total %lld\n", counter_names[c], total);
+    }
+
+    append(buffer, size, &pos, "# HELP router_native_phase_seconds Time spent per routing phase\n");
+    append(buffer, size, &pos, "# TYPE router_native_phase_seconds histogram\n");
+    for (int p = 0; p < METRIC_PHASE_COUNT; p++) {
+        long long cumulative = 0, count = 0, sum_ns = 0;
+        double bound = 1e-6;
+        for (int b = 0; b <= METRIC_HISTOGRAM_BUCKETS; b++) {
+            for (int s = 0; s < used; s++) {
+                cumulative += atomic_load_explicit(&slots[s].phases[p].buckets[b], memory_order_relaxed);
+            }
+            if (b < METRIC_HISTOGRAM_BUCKETS) {
+                append(buffer, size, &pos, "router_native_phase_seconds_bucket{phase=\"%s\",le=\"%.6f\"} %lld\n",
+                       phase_names[p], bound, cumulative);
+                bound *= 2.0;
+            } else {
+                append(buffer, size, &pos, "router_native_phase_seconds_bucket{phase=\"%s\",le=\"+Inf\"} %lld\n",
+                       phase_names[p], cumulative);
+            }
+        }
+        for (int s = 0; s < used; s++) {
+            count += atomic_load_explicit(&slots[s].phases[p].count, memory_order_relaxed);
+            sum_ns += atomic_load_explicit(&slots[s].phases[p].sum_ns, memory_order_relaxed);
+        }
+        append(buffer, size, &pos, "router_native_phase_seconds_sum{phase=\"%s\"} %.9f\n", phase_names[p], sum_ns / 1e9);
+        append(buffer, size, &pos, "router_native_phase_seconds_count{phase=\"%s\"} %lld\n", phase_names[p], count);
+    }
+
+    return pos;
+}
@@ -0,0 +1,49 @@
+#ifndef ROUTE_METRICS_H
+#define ROUTE_METRICS_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum MetricCounter {
+    METRIC_HEAP_PUSHES,
+    METRIC_HEAP_POPS,
+    METRIC_RELAXATIONS,
+    METRIC_STALE_POPS,
+    METRIC_SETTLED_NODES,
+    METRIC_BYTES_ALLOCATED,
+    METRIC_COUNTER_COUNT
+} MetricCounter;
+
+typedef enum MetricPhase {
+    METRIC_PHASE_PARSE,
+    METRIC_PHASE_BUILD,
+    METRIC_PHASE_SEARCH,
+    METRIC_PHASE_PATH,
+    METRIC_PHASE_SERIALIZE,
+    METRIC_PHASE_LOAD_GRAPH,   // reading the binary graph file in a route worker
+    METRIC_PHASE_COUNT
+} MetricPhase;
+
+// Histogram bucket i counts observations <= 2^i microseconds (1us .. ~8s)
+#define METRIC_HISTOGRAM_BUCKETS 24
+
+// Each thread writes to its own slot with relaxed atomics; readers sum
+// the slots. Callers should batch counts locally and add once per search.
+void metrics_add(MetricCounter counter, long long value);
+void metrics_observe(MetricPhase phase, double seconds);
+
+// Monotonic clock in seconds, for phase timers
+double metrics_now(void);
+
+// Write all metrics in Prometheus text format. Returns the length the
+// full output needs (like snprintf), so a larger buffer can be retried.
+size_t metrics_format_prometheus(char* buffer, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,323 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <float.h>
+#include <math.h>
+
+#include "route_worker.h"
+
+#ifdef _WIN32
+
+int run_route_worker(const char* socket_path, const char* graph_path) {
+    (void)socket_path;
+    (void)graph_path;
+    fprintf(stderr, "Route worker needs Unix domain sockets; run it under WSL\n");
+    return 1;
+}
+
+#else
+
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "csr_graph.h"
+#include "dijkstra_c.h"
+#include "delta_stepping.h"
+#include "edge_weights.h"
+#include "route_metrics.h"
+
+typedef struct WorkerContext {
+    CsrGraph* graph;
+    WeightLayer* weights;
+    const char* socket_path;
+} WorkerContext;
+
+typedef struct ConnectionArgs {
+    WorkerContext* ctx;
+    int fd;
+} ConnectionArgs;
+
+// Growable response buffer; the frame header is filled in last
+typedef struct ByteBuffer {
+    char* data;
+    size_t size;
+    size_t capacity;
+} ByteBuffer;
+
+static void buffer_put(ByteBuffer* buf, const void* src, size_t len) {
+    if (buf->size + len > buf->capacity) {
+        while (buf->size + len > buf->capacity) buf->capacity = buf->capacity ? buf->capacity * 2 : 4096;
+        buf->data = (char*)realloc(buf->data, buf->capacity);
+    }
+    memcpy(buf->data + buf->size, src, len);
+    buf->size += len;
+}
+
+static void buffer_put_i32(ByteBuffer* buf, int32_t value) { buffer_put(buf, &value, sizeof(value)); }
+static void buffer_put_i64(ByteBuffer* buf, int64_t value) { buffer_put(buf, &value, sizeof(value)); }
+static void buffer_put_f64(ByteBuffer* buf, double value) { buffer_put(buf, &value, sizeof(value)); }
+
+static int32_t get_i32(const char* src) { int32_t value; memcpy(&value, src, sizeof(value)); return value; }
+static uint32_t get_u32(const char* src) { uint32_t value; memcpy(&value, src, sizeof(value)); return value; }
+static double get_f64(const char* src) { double value; memcpy(&value, src, sizeof(value)); return value; }
+
+// Returns 1 when all bytes were read, 0 on EOF or error
+static int read_full(int fd, void* dst, size_t len) {
+    char* p = (char*)dst;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return 0;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 1;
+}
+
+static int write_full(int fd, const void* src, size_t len) {
+    const char* p = (const char*)src;
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return 0;
+        p += n;
+        len -= (size_t)n;
+    }
+    return 1;
+}
+
+static int handle_route(WorkerContext* ctx, const char* payload, uint32_t len, ByteBuffer* out) {
+    if (len != 9) return ROUTE_STATUS_BAD_REQUEST;
+    int start = get_i32(payload);
+    int end = get_i32(payload + 4);
+    int with_steps = payload[8] != 0;
+    if (start < 0 || start >= ctx->graph->node_count || end < 0 || end >= ctx->graph->node_count) {
+        return ROUTE_STATUS_BAD_REQUEST;
+    }
+
+    WeightSnapshot* snapshot = weight_layer_acquire(ctx->weights);
+    DijkstraResult* result = dijkstra_path_c(ctx->graph, snapshot, start, end, with_steps);
+    weight_layer_release(ctx->weights, snapshot);
+
+    double serialize_start = metrics_now();
+    buffer_put_f64(out, result->distance);
+    buffer_put_i32(out, result->iterations);
+    buffer_put_i32(out, result->path_length);
+    buffer_put_i32(out, result->explored_count);
+    if (result->path_length > 0) buffer_put(out, result->path, sizeof(int) * result->path_length);
+    if (result->explored_count > 0) buffer_put(out, result->explored, sizeof(int) * result->explored_count);
+    metrics_observe(METRIC_PHASE_SERIALIZE, metrics_now() - serialize_start);
+
+    int status = result->path_length > 0 ? ROUTE_STATUS_OK : ROUTE_STATUS_NO_PATH;
+    free_dijkstra_result(result);
+    return status;
+}
+
+static int handle_one_to_all(WorkerContext* ctx, const char* payload, uint32_t len, ByteBuffer* out) {
+    if (len != 16) return ROUTE_STATUS_BAD_REQUEST;
+    int start = get_i32(payload);
+    double delta = get_f64(payload + 4);
+    int threads = get_i32(payload + 12);
+    if (start < 0 || start >= ctx->graph->node_count) return ROUTE_STATUS_BAD_REQUEST;
+    if (threads > 64) threads = 64;
+
+    WeightSnapshot* snapshot = weight_layer_acquire(ctx->weights);
+    DeltaSteppingResult* result = delta_stepping_weighted_c(ctx->graph, snapshot, start, delta, threads);
+    weight_layer_release(ctx->weights, snapshot);
+
+    double serialize_start = metrics_now();
+    buffer_put_i32(out, result->node_count);
+    buffer_put_i32(out, result->buckets_processed);
+    buffer_put_i32(out, result->phases);
+    for (int i = 0; i < result->node_count; i++) {
+        buffer_put_f64(out, result->distances[i] == DBL_MAX ? INFINITY : result->distances[i]);
+    }
+    buffer_put(out, result->previous, sizeof(int) * result->node_count);
+    metrics_observe(METRIC_PHASE_SERIALIZE, metrics_now() - serialize_start);
+
+    free_delta_stepping_result(result);
+    return ROUTE_STATUS_OK;
+}
+
+static int handle_weights(WorkerContext* ctx, const char* payload, uint32_t len, ByteBuffer* out) {
+    if (len < 4) return ROUTE_STATUS_BAD_REQUEST;
+    int count = get_i32(payload);
+    if (count < 0 || (uint64_t)len != 4 + (uint64_t)count * 16) return ROUTE_STATUS_BAD_REQUEST;
+
+    EdgeWeightUpdate* updates = (EdgeWeightUpdate*)malloc(sizeof(EdgeWeightUpdate) * (count > 0 ? count : 1));
+    for (int i = 0; i < count; i++) {
+        const char* item = payload + 4 + (size_t)i * 16;
+        updates[i].from = get_i32(item);
+        updates[i].to = get_i32(item + 4);
+        updates[i].weight = get_f64(item + 8);
+    }
+
+    int applied = 0;
+    long long epoch = weight_layer_apply(ctx->weights, updates, count, &applied);
+    free(updates);
+    if (epoch < 0) return ROUTE_STATUS_BAD_REQUEST;
+
+    buffer_put_i64(out, epoch);
+    buffer_put_i32(out, applied);
+    return ROUTE_STATUS_OK;
+}
+
+static int handle_metrics(ByteBuffer* out) {
+    size_t size = 16384;
+    char* text = (char*)malloc(size);
+    size_t needed = metrics_format_prometheus(text, size);
+    if (needed >= size) {
+        size = needed + 1;
+        text = (char*)realloc(text, size);
+        metrics_format_prometheus(text, size);
+    }
+    buffer_put(out, text, strlen(text));
+    free(text);
+    return ROUTE_STATUS_OK;
+}
+
+static int handle_info(WorkerContext* ctx, ByteBuffer* out) {
+    WeightSnapshot* snapshot = weight_layer_acquire(ctx->weights);
+    buffer_put_i32(out, ctx->graph->node_count);
+    buffer_put_i32(out, ctx->graph->edge_count);
+    buffer_put_i64(out, snapshot->epoch);
+    weight_layer_release(ctx->weights, snapshot);
+    return ROUTE_STATUS_OK;
+}
+
+// Serve one client: read a frame, answer it, repeat until the peer hangs up
+static void* connection_thread(void* arg) {
+    ConnectionArgs* args = (ConnectionArgs*)arg;
+    WorkerContext* ctx = args->ctx;
+    int fd = args->fd;
+    free(args);
+
+    char header[ROUTE_FRAME_HEADER_SIZE];
+    char* payload = NULL;
+    uint32_t payload_capacity = 0;
+    ByteBuffer out = { NULL, 0, 0 };
+
+    while (read_full(fd, header, sizeof(header))) {
+        uint32_t len = get_u32(header);
+        uint32_t request_id = get_u32(header + 4);
+        uint8_t type = (uint8_t)header[8];
+        if (len > ROUTE_MAX_PAYLOAD) break;
+
+        if (len > payload_capacity) {
+            payload_capacity = len;
+            payload = (char*)realloc(payload, payload_capacity);
+        }
+        if (len > 0 && !read_full(fd, payload, len)) break;
+
+        out.size = 0;
+        char reserved[ROUTE_FRAME_HEADER_SIZE] = { 0 };
+        buffer_put(&out, reserved, sizeof(reserved));
+
+        int status;
+        switch (type) {
+            case ROUTE_MSG_ROUTE: status = handle_route(ctx, payload, len, &out); break;
+            case ROUTE_MSG_ONE_TO_ALL: status = handle_one_to_all(ctx, payload, len, &out); break;
+            case ROUTE_MSG_WEIGHTS: status = handle_weights(ctx, payload, len, &out); break;
+            case ROUTE_MSG_METRICS: status = handle_metrics(&out); break;
+            case ROUTE_MSG_INFO: status = handle_info(ctx, &out); break;
+            default: status = ROUTE_STATUS_BAD_REQUEST; break;
+        }
+        if (status == ROUTE_STATUS_BAD_REQUEST) out.size = ROUTE_FRAME_HEADER_SIZE;
+
+        uint32_t response_len = (uint32_t)(out.size - ROUTE_FRAME_HEADER_SIZE);
+        memcpy(out.data, &response_len, 4);
+        memcpy(out.data + 4, &request_id, 4);
+        out.data[8] = (char)type;
+        out.data[9] = (char)status;
+        if (!write_full(fd, out.data, out.size)) break;
+    }
+
+    close(fd);
+    free(payload);
+    free(out.data);
+    return NULL;
+}
+
+// The parent owns our lifetime: exit as soon as it closes our stdin
+static void* watch_parent(void* arg) {
+    WorkerContext* ctx = (WorkerContext*)arg;
+    char sink[256];
+    while (1) {
+        ssize_t n = read(STDIN_FILENO, sink, sizeof(sink));
+        if (n == 0 || (n < 0 && errno != EINTR)) break;
+    }
+    unlink(ctx->socket_path);
+    _exit(0);
+    return NULL;
+}
+
+int run_route_worker(const char* socket_path, const char* graph_path) {
+    signal(SIGPIPE, SIG_IGN);
+
+    double load_start = metrics_now();
+    CsrGraph* graph = load_csr_graph(graph_path);
+    if (!graph) {
+        fprintf(stderr, "Failed to load graph: %s\n", graph_path);
+        return 1;
+    }
+    metrics_observe(METRIC_PHASE_LOAD_GRAPH, metrics_now() - load_start);
+
+    WorkerContext ctx;
+    ctx.graph = graph;
+    ctx.weights = create_weight_layer(graph);
+    ctx.socket_path = socket_path;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", socket_path);
+        return 1;
+    }
+    strcpy(addr.sun_path, socket_path);
+
+    int listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path);
+    if (listen_fd < 0 || bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_fd, 16) != 0) {
+        perror("Route worker socket");
+        return 1;
+    }
+
+    pthread_t watchdog;
+    pthread_create(&watchdog, NULL, watch_parent, &ctx);
+    pthread_detach(watchdog);
+
+    printf("ready %d %d\n", graph->node_count, graph->edge_count);
+    fflush(stdout);
+
+    while (1) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            perror("Route worker accept");
+            break;
+        }
+
+        ConnectionArgs* args = (ConnectionArgs*)malloc(sizeof(ConnectionArgs));
+        args->ctx = &ctx;
+        args->fd = fd;
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, connection_thread, args) != 0) {
+            close(fd);
+            free(args);
+            continue;
+        }
+        pthread_detach(thread);
+    }
+
+    close(listen_fd);
+    unlink(socket_path);
+    return 1;
+}
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef ROUTE_WORKER_H
+#define ROUTE_WORKER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Wire protocol between the Node server and a route worker, over a Unix
+// domain socket. All integers are little-endian. Every frame, in both
+// directions, starts with a 12-byte header:
+//
+//   uint32 payload_length, uint32 request_id, uint8 type, uint8 status, uint16 reserved
+//
+// Requests on one connection are answered in order, each response echoing
+// the request_id, so a client may pipeline any number of frames per write.
+#define ROUTE_FRAME_HEADER_SIZE 12
+#define ROUTE_MAX_PAYLOAD (64 * 1024 * 1024)
+
+// Request types and payloads
+//   ROUTE       int32 start, int32 end, uint8 with_steps
+//               -> float64 distance, int32 iterations, int32 path_length,
+//                  int32 explored_count, int32 path[], int32 explored[]
+//   ONE_TO_ALL  int32 start, float64 delta, int32 threads
+//               -> int32 node_count, int32 buckets, int32 phases,
+//                  float64 distances[node_count], int32 previous[node_count]
+//   WEIGHTS     int32 count, { int32 from, int32 to, float64 weight }[count]
+//               weight is +Inf to close the edge, -1 to restore it, else
+//               finite and >= 0; any other weight rejects the whole batch
+//               -> int64 epoch, int32 applied
+//   METRICS     (empty) -> Prometheus text
+//   INFO        (empty) -> int32 node_count, int32 edge_count, int64 epoch
+#define ROUTE_MSG_ROUTE 1
+#define ROUTE_MSG_ONE_TO_ALL 2
+#define ROUTE_MSG_WEIGHTS 3
+#define ROUTE_MSG_METRICS 4
+#define ROUTE_MSG_INFO 5
+
+#define ROUTE_STATUS_OK 0
+#define ROUTE_STATUS_BAD_REQUEST 1
+#define ROUTE_STATUS_NO_PATH 2
+
+// Load the binary graph once, then serve requests on socket_path until
+// stdin is closed by the parent process. Prints "ready <nodes> <edges>"
+// on stdout once the socket is listening.
+int run_route_worker(const char* socket_path, const char* graph_path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
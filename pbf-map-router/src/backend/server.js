@@ -3,10 +3,15 @@ const multer = require('multer');
 const path = require('path');
 const cors = require('cors');
 const fs = require('fs');
+const os = require('os');
 
-const { parsePBFFile } = require('./pbfParser');
-const { dijkstraPath, buildGraph } = require('./routeFinder');
+const { dijkstraPath } = require('./routeFinder');
+const { loadGraphInBackground } = require('./graphLoader');
+const { GraphStore } = require('./graphStore');
+const { EdgeWeightStore } = require('./edgeWeights');
+const { RouteWorkerPool } = require('./routeWorker');
 const config = require('./config');
+const metrics = require('./metrics');
 
 const app = express();
 
@@ -32,14 +37,6 @@ if (!fs.existsSync(config.UPLOAD_DIR)) {
   fs.mkdirSync(config.UPLOAD_DIR, { recursive: true });
 }
 
-let currentMapData = { 
-  nodes: {}, 
-  ways: [], 
-  graph: {}
-};
-
-let parseInProgress = false;
-
 function cleanupMemory() {
   if (global.gc) {
     global.gc();
@@ -47,6 +44,256 @@ function cleanupMemory() {
   }
 }
 
+const graphStore = new GraphStore({
+  nodes: {},
+  ways: [],
+  graph: {}
+}, (version, data) => {
+  console.log(` Graph v${version} released`);
+  if (data.workers) stopRouteWorkers(data.workers);
+  cleanupMemory();
+});
+
+const edgeWeights = new EdgeWeightStore();
+
+metrics.addCollector(() => {
+  const data = graphStore.current.data;
+  return data.workers ? data.workers.pool.metrics().catch(() => '') : '';
+});
+
+function routeWorkersEnabled() {
+  return config.ROUTE_WORKERS > 0 && fs.existsSync(config.ROUTE_WORKER_BIN);
+}
+
+// Start native workers on the binary graph written by the loader.
+// Returns null (JS routing only) if they fail to come up.
+async function startRouteWorkers(nodeIds, binaryPath) {
+  const pool = new RouteWorkerPool({
+    binPath: config.ROUTE_WORKER_BIN,
+    graphPath: binaryPath,
+    size: config.ROUTE_WORKERS,
+    socketPrefix: binaryPath.replace(/\.bin$/, '')
+  });
+
+  try {
+    await pool.start();
+  } catch (err) {
+    console.error(` Route workers unavailable: ${err.message}`);
+    fs.unlink(binaryPath, () => {});
+    return null;
+  }
+
+  const nodeIndex = new Map();
+  nodeIds.forEach((id, i) => nodeIndex.set(id, i));
+  console.log(` Started ${config.ROUTE_WORKERS} route workers`);
+  return { pool, nodeIndex, nodeIds, binaryPath };
+}
+
+function stopRouteWorkers(workers) {
+  workers.pool.close();
+  fs.unlink(workers.binaryPath, () => {});
+}
+
+// Translate edge overrides keyed by OSM id into worker updates by node index.
+// Pairs without an override are sent as -1, which restores the base weight.
+function toWorkerUpdates(workers, pairs, snapshot) {
+  const updates = [];
+  pairs.forEach(([from, to]) => {
+    const fromIdx = workers.nodeIndex.get(from);
+    const toIdx = workers.nodeIndex.get(to);
+    if (fromIdx === undefined || toIdx === undefined) return;
+    const nodeOverrides = snapshot.overrides.get(from);
+    const weight = nodeOverrides && nodeOverrides.has(to) ? nodeOverrides.get(to) : -1;
+    updates.push({ from: fromIdx, to: toIdx, weight });
+  });
+  return updates;
+}
+
+function overridePairs(snapshot) {
+  const pairs = [];
+  snapshot.overrides.forEach((nodeOverrides, from) => {
+    nodeOverrides.forEach((weight, to) => pairs.push([from, to]));
+  });
+  return pairs;
+}
+
+// Requests on a worker connection run in order, so weight updates sent
+// here apply before any route query issued after this call. If any worker
+// misses the update, the pool stops serving this graph and queries fall
+// back to JS, which always reads the current overrides.
+function sendWorkerWeights(data, updates) {
+  const workers = data.workers;
+  if (!workers || updates.length === 0) return Promise.resolve();
+  return workers.pool.applyWeights(updates).catch(err => {
+    console.error(` Route worker weight update failed, routing in JS: ${err.message}`);
+    if (data.workers === workers) {
+      data.workers = null;
+      stopRouteWorkers(workers);
+    }
+  });
+}
+
+// Count nodes with a finite distance <= radius and return the `limit`
+// nearest, closest first. A bounded max-heap keeps this O(n log limit).
+function nearestWithin(distances, radius, limit) {
+  const heap = [];
+  let count = 0;
+
+  const siftDown = i => {
+    while (true) {
+      const left = 2 * i + 1;
+      const right = left + 1;
+      let largest = i;
+      if (left < heap.length && distances[heap[left]] > distances[heap[largest]]) largest = left;
+      if (right < heap.length && distances[heap[right]] > distances[heap[largest]]) largest = right;
+      if (largest === i) return;
+      [heap[i], heap[largest]] = [heap[largest], heap[i]];
+      i = largest;
+    }
+  };
+
+  for (let idx = 0; idx < distances.length; idx++) {
+    const distance = distances[idx];
+    // Unreachable nodes come back as Infinity
+    if (!Number.isFinite(distance) || distance > radius) continue;
+    count++;
+
+    if (heap.length < limit) {
+      heap.push(idx);
+      let i = heap.length - 1;
+      while (i > 0) {
+        const parent = (i - 1) >> 1;
+        if (distances[heap[parent]] >= distances[heap[i]]) break;
+        [heap[i], heap[parent]] = [heap[parent], heap[i]];
+        i = parent;
+      }
+    } else if (distance < distances[heap[0]]) {
+      heap[0] = idx;
+      siftDown(0);
+    }
+  }
+
+  return { count, nearest: heap.sort((a, b) => distances[a] - distances[b]) };
+}
+
+async function routeWithWorkers(workers, start, end) {
+  const from = workers.nodeIndex.get(start);
+  const to = workers.nodeIndex.get(end);
+  if (from === undefined || to === undefined) {
+    return { path: null, distance: Infinity, iterations: 0 };
+  }
+
+  const result = await workers.pool.route(from, to);
+  return {
+    path: result.found && result.path.length > 1 ? result.path.map(idx => workers.nodeIds[idx]) : null,
+    distance: result.found ? result.distance : Infinity,
+    iterations: result.iterations
+  };
+}
+
+let loadStatus = {
+  state: 'idle',
+  filename: null,
+  progress: null,
+  startedAt: null,
+  finishedAt: null,
+  error: null
+};
+
+function isLoading() {
+  return loadStatus.state === 'loading';
+}
+
+// Build the new graph in the background, then swap it in atomically.
+// Routing keeps using the previous graph until the swap.
+async function loadAndPublish(filePath, filename) {
+  loadStatus = {
+    state: 'loading',
+    filename: filename,
+    progress: { phase: 'start' },
+    startedAt: Date.now(),
+    finishedAt: null,
+    error: null
+  };
+
+  // Until the graph is published, this load owns the binary file and workers
+  let binaryPath = null;
+  let workers = null;
+  let published = false;
+
+  try {
+    binaryPath = routeWorkersEnabled()
+      ? path.join(os.tmpdir(), `pbf-router-${process.pid}-${Date.now()}.bin`)
+      : null;
+
+    const loaded = await loadGraphInBackground(filePath, progress => {
+      loadStatus.progress = progress;
+    }, binaryPath);
+
+    if (binaryPath) {
+      loadStatus.progress = { phase: 'start-workers' };
+      workers = await startRouteWorkers(loaded.nodeIds, binaryPath);
+    }
+
+    const data = {
+      nodes: loaded.nodes,
+      ways: loaded.ways,
+      graph: loaded.graph,
+      workers: workers
+    };
+    const version = graphStore.publish(data);
+    published = true;
+
+    // Replay live overrides onto the fresh workers in the same tick as the
+    // publish, so no update can slip in between and every query queues behind it
+    const weights = edgeWeights.snapshot();
+    if (workers) sendWorkerWeights(data, toWorkerUpdates(workers, overridePairs(weights), weights));
+
+    loadStatus.state = 'ready';
+    loadStatus.progress = { phase: 'done' };
+    loadStatus.finishedAt = Date.now();
+
+    console.log(` Ready for routing (graph v${version})`);
+
+    return {
+      success: true,
+      nodeCount: Object.keys(loaded.nodes).length,
+      wayCount: loaded.ways.length,
+      version: version,
+      bounds: loaded.bounds
+    };
+  } catch (err) {
+    if (!published) {
+      if (workers) {
+        stopRouteWorkers(workers);
+      } else if (binaryPath) {
+        fs.unlink(binaryPath, () => {});
+      }
+    }
+    loadStatus.state = 'error';
+    loadStatus.error = err.message;
+    loadStatus.finishedAt = Date.now();
+    throw err;
+  }
+}
+
+// Pin the current graph for the lifetime of a request so a concurrent
+// reload cannot free it mid-query
+function withGraph(req, res, next) {
+  const handle = graphStore.acquire();
+  let released = false;
+  const release = () => {
+    if (!released) {
+      released = true;
+      graphStore.release(handle);
+    }
+  };
+  res.on('finish', release);
+  res.on('close', release);
+  req.mapData = handle.data;
+  next();
+}
+
 app.post('/api/load-local-pbf', async (req, res) => {
   const { filename } = req.body;
 
@@ -54,13 +301,11 @@ app.post('/api/load-local-pbf', async (req, res) => {
     return res.status(400).json({ error: 'No filename provided' });
   }
 
-  if (parseInProgress) {
+  if (isLoading()) {
     return res.status(400).json({ error: 'Parse already in progress' });
   }
 
   try {
-    parseInProgress = true;
-
     let filePath = path.join(config.UPLOAD_DIR, filename);
     if (!fs.existsSync(filePath)) {
       const dataDir = path.join(__dirname, '../../data');
@@ -76,52 +321,14 @@ app.post('/api/load-local-pbf', async (req, res) => {
     const stats = fs.statSync(filePath);
     console.log(` Size: ${(stats.size / 1024 / 1024).toFixed(2)} MB`);
 
-    const parsed = await parsePBFFile(filePath);
-
-    console.log(` Parsed ${Object.keys(parsed.nodes).length} nodes`);
-
-    const graph = buildGraph(parsed.nodes, parsed.ways);
-
-    currentMapData = {
-      nodes: parsed.nodes,
-      ways: parsed.ways,
-      graph: graph
-    };
-
-    console.log(' Ready for routing');
-
-    let minLat = Infinity, maxLat = -Infinity;
-    let minLon = Infinity, maxLon = -Infinity;
-    
-    const nodeValues = Object.values(parsed.nodes);
-    if (nodeValues.length > 0) {
-      nodeValues.forEach(node => {
-        if (node.lat < minLat) minLat = node.lat;
-        if (node.lat > maxLat) maxLat = node.lat;
-        if (node.lon < minLon) minLon = node.lon;
-        if (node.lon > maxLon) maxLon = node.lon;
-      });
-    }
-
-    parseInProgress = false;
+    const result = await loadAndPublish(filePath, filename);
 
     res.json({
-      success: true,
-      nodeCount: Object.keys(parsed.nodes).length,
-      wayCount: parsed.ways.length,
-      message: `Loaded ${filename}`,
-      bounds: nodeValues.length > 0 ? {
-        minLat: minLat,
-        maxLat: maxLat,
-        minLon: minLon,
-        maxLon: maxLon,
-        centerLat: (minLat + maxLat) / 2,
-        centerLon: (minLon + maxLon) / 2
-      } : null
+      ...result,
+      message: `Loaded ${filename}`
     });
 
   } catch (err) {
-    parseInProgress = false;
     console.error(err.message);
     res.status(500).json({ error: err.message });
   }
@@ -132,62 +339,33 @@ app.post('/api/upload-pbf', upload.single('file'), async (req, res) => {
     return res.status(400).json({ error: 'No file uploaded' });
   }
 
-  if (parseInProgress) {
+  if (isLoading()) {
     return res.status(400).json({ error: 'Parse already in progress' });
   }
 
   try {
-    parseInProgress = true;
     const filePath = req.file.path;
-    
-    const parsed = await parsePBFFile(filePath);
 
-    const graph = buildGraph(parsed.nodes, parsed.ways);
-
-    currentMapData = {
-      nodes: parsed.nodes,
-      ways: parsed.ways,
-      graph: graph
-    };
-
-    let minLat = Infinity, maxLat = -Infinity;
-    let minLon = Infinity, maxLon = -Infinity;
-    
-    const nodeValues = Object.values(parsed.nodes);
-    if (nodeValues.length > 0) {
-      nodeValues.forEach(node => {
-        if (node.lat < minLat) minLat = node.lat;
-        if (node.lat > maxLat) maxLat = node.lat;
-        if (node.lon < minLon) minLon = node.lon;
-        if (node.lon > maxLon) maxLon = node.lon;
-      });
-    }
+    const result = await loadAndPublish(filePath, req.file.originalname);
 
     fs.unlinkSync(filePath);
 
-    parseInProgress = false;
-
-    res.json({
-      success: true,
-      nodeCount: Object.keys(parsed.nodes).length,
-      wayCount: parsed.ways.length,
-      bounds: nodeValues.length > 0 ? {
-        minLat: minLat,
-        maxLat: maxLat,
-        minLon: minLon,
-        maxLon: maxLon,
-        centerLat: (minLat + maxLat) / 2,
-        centerLon: (minLon + maxLon) / 2
-      } : null
-    });
+    res.json(result);
 
   } catch (err) {
-    parseInProgress = false;
     console.error(err.message);
     res.status(500).json({ error: err.message });
   }
 });
 
+app.get('/api/load-status', (req, res) => {
+  res.json({
+    ...loadStatus,
+    elapsedMs: loadStatus.startedAt ? (loadStatus.finishedAt || Date.now()) - loadStatus.startedAt : 0,
+    graphVersion: graphStore.current.version
+  });
+});
+
 app.get('/api/list-files', (req, res) => {
   try {
     const files = new Set();
@@ -212,7 +390,8 @@ app.get('/api/list-files', (req, res) => {
   }
 });
 
-app.post('/api/find-route', (req, res) => {
+app.post('/api/find-route', withGraph, async (req, res) => {
+  const currentMapData = req.mapData;
   const { start, end, animate = false } = req.body;
 
   if (!start || !end) {
@@ -224,12 +403,28 @@ app.post('/api/find-route', (req, res) => {
   }
 
   try {
-    const result = dijkstraPath(currentMapData.graph, start.toString(), end.toString(), animate);
+    const weights = edgeWeights.snapshot();
+    let result = null;
+
+    // Plain queries go to the native workers; animations need the JS search trace
+    if (!animate && currentMapData.workers) {
+      try {
+        result = await routeWithWorkers(currentMapData.workers, start.toString(), end.toString());
+      } catch (err) {
+        console.error(` Route worker failed, using JS: ${err.message}`);
+      }
+    }
+    if (!result) {
+      result = dijkstraPath(currentMapData.graph, start.toString(), end.toString(), animate, weights);
+    }
+    metrics.add('routes');
 
     if (!result.path) {
       return res.json({ error: 'No path found' });
     }
 
+    const serializeStart = metrics.now();
+
     const pathCoords = result.path.map(nodeId => {
       const node = currentMapData.nodes[nodeId];
       return { id: nodeId, lat: node.lat, lon: node.lon };
@@ -310,7 +505,67 @@ app.post('/api/find-route', (req, res) => {
       updatedEdges: updatedEdges,
       allVisitedEdges: allVisitedEdges,
       waveFront: waveFront,
-      iterations: result.iterations
+      iterations: result.iterations,
+      weightsEpoch: weights.epoch
+    });
+    metrics.observe('serialize', metrics.now() - serializeStart);
+
+  } catch (err) {
+    console.error(err.message);
+    res.status(500).json({ error: err.message });
+  }
+});
+
+// Distances from one node to every other, via parallel delta-stepping in
+// the route workers. Returns the nearest reachable nodes, up to `limit`.
+app.post('/api/one-to-all', withGraph, async (req, res) => {
+  const currentMapData = req.mapData;
+  const { start, maxDistance, delta = 0, threads = config.ONE_TO_ALL_THREADS } = req.body;
+  const limit = req.body.limit == null ? 1000 : parseInt(req.body.limit);
+  const radius = maxDistance == null ? Infinity : Number(maxDistance);
+
+  if (!start) {
+    return res.status(400).json({ error: 'No start node' });
+  }
+
+  if (!(limit > 0)) {
+    return res.status(400).json({ error: 'limit must be a positive integer' });
+  }
+
+  if (Object.keys(currentMapData.graph).length === 0) {
+    return res.status(400).json({ error: 'No map loaded' });
+  }
+
+  const workers = currentMapData.workers;
+  if (!workers) {
+    return res.status(503).json({ error: 'One-to-all search needs the native route workers' });
+  }
+
+  const startIdx = workers.nodeIndex.get(start.toString());
+  if (startIdx === undefined) {
+    return res.status(400).json({ error: `Start node not in graph: ${start}` });
+  }
+
+  try {
+    const weights = edgeWeights.snapshot();
+    const result = await workers.pool.oneToAll(startIdx, Number(delta) || 0, parseInt(threads) || 1);
+
+    const { count, nearest } = nearestWithin(result.distances, radius, limit);
+
+    const nodes = nearest.map(idx => {
+      const id = workers.nodeIds[idx];
+      const node = currentMapData.nodes[id];
+      return { id, lat: node ? node.lat : null, lon: node ? node.lon : null, distance: result.distances[idx] };
+    });
+
+    res.json({
+      success: true,
+      start: start.toString(),
+      reachable: count,
+      nodes: nodes,
+      buckets: result.buckets,
+      phases: result.phases,
+      weightsEpoch: weights.epoch
     });
 
   } catch (err) {
@@ -319,7 +574,85 @@ app.post('/api/find-route', (req, res) => {
   }
 });
 
-app.get('/api/ways', (req, res) => {
+app.post('/api/edge-weights', withGraph, async (req, res) => {
+  const currentMapData = req.mapData;
+  const { updates } = req.body;
+
+  if (!Array.isArray(updates) || updates.length === 0) {
+    return res.status(400).json({ error: 'updates array required' });
+  }
+
+  const invalid = updates.findIndex(update =>
+    !update || typeof update !== 'object' || update.from == null || update.to == null);
+  if (invalid !== -1) {
+    return res.status(400).json({ error: `updates[${invalid}] needs from and to` });
+  }
+
+  if (Object.keys(currentMapData.graph).length === 0) {
+    return res.status(400).json({ error: 'No map loaded' });
+  }
+
+  try {
+    const result = edgeWeights.apply(currentMapData.graph, updates);
+
+    if (currentMapData.workers) {
+      const pairs = [];
+      updates.forEach(update => {
+        const from = update.from.toString();
+        const to = update.to.toString();
+        pairs.push([from, to]);
+        if (update.bidirectional !== false) pairs.push([to, from]);
+      });
+      await sendWorkerWeights(currentMapData, toWorkerUpdates(currentMapData.workers, pairs, edgeWeights.snapshot()));
+    }
+
+    res.json(result);
+
+  } catch (err) {
+    console.error(err.message);
+    res.status(500).json({ error: err.message });
+  }
+});
+
+app.get('/api/edge-weights', (req, res) => {
+  const limit = parseInt(req.query.limit) || 1000;
+  const snapshot = edgeWeights.snapshot();
+  const overrides = [];
+
+  for (const [from, nodeOverrides] of snapshot.overrides) {
+    for (const [to, weight] of nodeOverrides) {
+      if (overrides.length >= limit) break;
+      overrides.push({ from, to, weight: weight === Infinity ? null : weight, closed: weight === Infinity });
+    }
+    if (overrides.length >= limit) break;
+  }
+
+  res.json({
+    epoch: snapshot.epoch,
+    overrideCount: snapshot.count,
+    overrides: overrides
+  });
+});
+
+app.delete('/api/edge-weights', withGraph, async (req, res) => {
+  const workers = req.mapData.workers;
+  const pairs = overridePairs(edgeWeights.snapshot());
+  const epoch = edgeWeights.clear();
+
+  if (workers) {
+    await sendWorkerWeights(req.mapData, toWorkerUpdates(workers, pairs, edgeWeights.snapshot()));
+  }
+
+  res.json({ epoch: epoch, overrideCount: 0 });
+});
+
+app.get('/api/metrics', async (req, res) => {
+  res.set('Content-Type', 'text/plain; version=0.0.4');
+  res.send(await metrics.render());
+});
+
+app.get('/api/ways', withGraph, (req, res) => {
+  const currentMapData = req.mapData;
   const limit = parseInt(req.query.limit) || 1000;
   const ways = currentMapData.ways.slice(0, limit);
   
@@ -340,7 +673,8 @@ app.get('/api/ways', (req, res) => {
   res.json({ ways: waysWithCoords });
 });
 
-app.get('/api/map-info', (req, res) => {
+app.get('/api/map-info', withGraph, (req, res) => {
+  const currentMapData = req.mapData;
   res.json({
     nodeCount: Object.keys(currentMapData.nodes).length,
     wayCount: currentMapData.ways.length,
@@ -348,13 +682,15 @@ app.get('/api/map-info', (req, res) => {
   });
 });
 
-app.get('/api/nodes', (req, res) => {
+app.get('/api/nodes', withGraph, (req, res) => {
+  const currentMapData = req.mapData;
   const limit = parseInt(req.query.limit) || 500;
   const nodes = Object.values(currentMapData.nodes).slice(0, limit);
   res.json(nodes);
 });
 
-app.get('/api/node/:id', (req, res) => {
+app.get('/api/node/:id', withGraph, (req, res) => {
+  const currentMapData = req.mapData;
   const nodeId = req.params.id;
   const node = currentMapData.nodes[nodeId];
   
@@ -374,7 +710,8 @@ app.get('/api/node/:id', (req, res) => {
   });
 });
 
-app.post('/api/search-nodes', (req, res) => {
+app.post('/api/search-nodes', withGraph, (req, res) => {
+  const currentMapData = req.mapData;
   const { minLat, maxLat, minLon, maxLon, limit = 100 } = req.body;
   
   if (!minLat || !maxLat || !minLon || !maxLon) {